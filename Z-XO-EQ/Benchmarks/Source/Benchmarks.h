@@ -0,0 +1,124 @@
+/*
+  ==============================================================================
+
+    Shared by the benchmarks: a list of named results written as JSON, and
+    the comparison of two such files from different builds.
+
+    Every result has a name that stays the same between builds, so two runs
+    are matched by it. Time per sample or per call is what gets compared,
+    the other fields are only there for whoever reads the file.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <iostream>
+#include <JuceHeader.h>
+
+struct BenchmarkResults
+{
+    void add(const juce::String& name, const juce::NamedValueSet& values)
+    {
+        auto* result = new juce::DynamicObject();
+        result->setProperty("name", name);
+
+        for (auto& value : values)
+            result->setProperty(value.name, value.value);
+
+        results.add(juce::var(result));
+    }
+
+    // 'label' tells the builds apart, a commit or a branch name
+    juce::String toJSON(const juce::String& label) const
+    {
+        auto* root = new juce::DynamicObject();
+        root->setProperty("label", label);
+        root->setProperty("date", juce::Time::getCurrentTime().toISO8601(true));
+        root->setProperty("cpu", juce::SystemStats::getCpuModel());
+        root->setProperty("os", juce::SystemStats::getOperatingSystemName());
+        root->setProperty("results", results);
+
+        return juce::JSON::toString(juce::var(root));
+    }
+
+    // a result per line on stderr, so a run can be followed while stdout carries the JSON
+    static void log(const juce::String& name, double timePerUnit, const juce::String& unit)
+    {
+        std::cerr << name << ": " << juce::String(timePerUnit, 2) << " " << unit << std::endl;
+    }
+
+private:
+    juce::Array<juce::var> results;
+};
+
+// the time fields of a result, in the order they are looked for
+inline const juce::StringArray& getBenchmarkTimeFields()
+{
+    static const juce::StringArray fields{ "nsPerSample", "usPerCall" };
+    return fields;
+}
+
+/** Prints the change of every result found in both files, returns how many got slower by more than the threshold (in %). */
+inline int compareBenchmarks(const juce::File& baselineFile, const juce::File& candidateFile, double threshold)
+{
+    auto baseline = juce::JSON::parse(baselineFile);
+    auto candidate = juce::JSON::parse(candidateFile);
+
+    if (!baseline.isObject() || !candidate.isObject())
+    {
+        std::cerr << "could not read " << (baseline.isObject() ? candidateFile : baselineFile).getFullPathName() << std::endl;
+        return -1;
+    }
+
+    auto findTime = [](const juce::var& result, juce::String& field)
+    {
+        for (auto& name : getBenchmarkTimeFields())
+        {
+            if (result.hasProperty(name))
+            {
+                field = name;
+                return (double)result[juce::Identifier(name)];
+            }
+        }
+
+        return 0.0;
+    };
+
+    int regressions = 0;
+
+    for (auto& result : *candidate["results"].getArray())
+    {
+        auto name = result["name"].toString();
+
+        for (auto& reference : *baseline["results"].getArray())
+        {
+            if (reference["name"].toString() != name)
+                continue;
+
+            juce::String field;
+            auto before = findTime(reference, field);
+            auto after = findTime(result, field);
+
+            if (before <= 0.0 || field.isEmpty())
+                break;
+
+            auto change = (after / before - 1.0) * 100.0;
+            auto isRegression = change > threshold;
+
+            if (isRegression)
+                ++regressions;
+
+            std::cout << (isRegression ? "SLOWER " : "       ") << name << ": "
+                      << juce::String(before, 2) << " -> " << juce::String(after, 2) << " " << field
+                      << " (" << (change >= 0.0 ? "+" : "") << juce::String(change, 1) << " %)" << std::endl;
+            break;
+        }
+    }
+
+    return regressions;
+}
+
+// Each runs its cases one after the other on the calling thread, 'quick' cuts the time spent per case
+void runProcessorBenchmarks(BenchmarkResults& results, bool quick);
+void runEditorBenchmarks(BenchmarkResults& results, bool quick);
@@ -0,0 +1,190 @@
+/*
+  ==============================================================================
+
+    Times the analyzer and ResponseCurveComponent without a window.
+
+    The component is made at a few sizes for each view and source. Before
+    every frame the FIFOs get the audio of a 60 Hz frame, as processBlock
+    would push it, and updateFrame(), paint() into an image and resized()
+    are timed separately. The FFT and generatePath are timed on their own
+    for every FFTOrder, on 800 pixels of width.
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/PluginEditor.h"
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+    constexpr double frameRate = 60.0;
+
+    const juce::Rectangle<int> componentSizes[] = { { 400, 200 }, { 800, 400 }, { 1600, 800 } };
+    const FFTOrder fftOrders[] = { order2048, order4096, order8192, order16384 };
+
+    void setParameter(ZXOEQAudioProcessor& processor, const juce::String& id, float value)
+    {
+        auto* parameter = processor.state.getParameter(id);
+        jassert(parameter != nullptr);
+
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+
+    void fillWithNoise(juce::AudioBuffer<float>& buffer, juce::Random& random)
+    {
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample(ch, i, 0.25f * (2.f * random.nextFloat() - 1.f));
+    }
+
+    // microseconds per call, 'prepare' runs before every call but isn't timed
+    template <typename Prepare, typename Call>
+    double timeCalls(int numCalls, Prepare&& prepare, Call&& call)
+    {
+        juce::int64 ticks = 0;
+
+        for (int i = 0; i < numCalls; ++i)
+        {
+            prepare();
+
+            auto startTicks = juce::Time::getHighResolutionTicks();
+            call();
+            ticks += juce::Time::getHighResolutionTicks() - startTicks;
+        }
+
+        return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e6 / numCalls;
+    }
+
+    void addResult(BenchmarkResults& results, const juce::String& name, juce::Rectangle<int> size, int numCalls, double usPerCall)
+    {
+        juce::NamedValueSet values;
+        values.set("width", size.getWidth());
+        values.set("height", size.getHeight());
+        values.set("calls", numCalls);
+        values.set("usPerCall", usPerCall);
+        values.set("frameBudgetPercent", usPerCall * frameRate / 1.0e4);
+
+        results.add(name, values);
+        BenchmarkResults::log(name, usPerCall, "us/call");
+    }
+
+    void runComponentBenchmarks(BenchmarkResults& results, int numCalls)
+    {
+        ZXOEQAudioProcessor processor;
+        processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        juce::Random random(1);
+        juce::AudioBuffer<float> block(2, blockSize);
+
+        auto blocksPerFrame = juce::roundToInt(sampleRate / frameRate / blockSize);
+        auto views = getAnalyzerViewNames();
+
+        for (int view = 0; view < views.size(); ++view)
+        {
+            for (auto source : { Source_Output, Source_Difference })
+            {
+                setParameter(processor, "Analyzer View", (float)view);
+                setParameter(processor, "Analyzer Source", (float)source);
+
+                auto pushFrame = [&]()
+                {
+                    for (int i = 0; i < blocksPerFrame; ++i)
+                    {
+                        fillWithNoise(block, random);
+
+                        if (source != Source_Output)
+                        {
+                            processor.inputLeftChannelFifo.update(block);
+                            processor.inputRightChannelFifo.update(block);
+                        }
+
+                        processor.leftChannelFifo.update(block);
+                        processor.rightChannelFifo.update(block);
+                    }
+                };
+
+                auto suffix = "/" + views[view] + "/" + getAnalyzerSourceNames()[source];
+
+                for (auto size : componentSizes)
+                {
+                    auto sizeName = "/" + juce::String(size.getWidth()) + "x" + juce::String(size.getHeight());
+
+                    ResponseCurveComponent component(processor);
+                    component.setBounds(size);
+
+                    // the first frames fill the analysis windows
+                    for (int i = 0; i < 4; ++i)
+                    {
+                        pushFrame();
+                        component.updateFrame();
+                    }
+
+                    addResult(results, "editor/updateFrame" + suffix + sizeName, size, numCalls,
+                        timeCalls(numCalls, pushFrame, [&] { component.updateFrame(); }));
+
+                    juce::Image image(juce::Image::PixelFormat::ARGB, size.getWidth(), size.getHeight(), true);
+
+                    addResult(results, "editor/paint" + suffix + sizeName, size, numCalls,
+                        timeCalls(numCalls, [] {}, [&]
+                        {
+                            juce::Graphics g(image);
+                            component.paint(g);
+                        }));
+
+                    addResult(results, "editor/resized" + suffix + sizeName, size, numCalls,
+                        timeCalls(numCalls, [] {}, [&] { component.resized(); }));
+                }
+            }
+        }
+
+        processor.releaseResources();
+    }
+
+    void runAnalyzerBenchmarks(BenchmarkResults& results, int numCalls)
+    {
+        const juce::Rectangle<int> pathArea{ 800, 400 };
+
+        juce::Random random(1);
+
+        for (auto order : fftOrders)
+        {
+            auto orderName = "/order=" + juce::String(1 << order);
+
+            FFTDataGenerator<std::vector<float>> generator;
+            generator.changeOrder(order);
+
+            juce::AudioBuffer<float> monoBuffer(1, generator.getFFTSize());
+            std::vector<float> fftData;
+
+            addResult(results, "analyzer/fft" + orderName, pathArea, numCalls,
+                timeCalls(numCalls, [&] { fillWithNoise(monoBuffer, random); },
+                    [&]
+                    {
+                        generator.produceFFTDataForRendering(monoBuffer, -100.f);
+                        generator.getFFTData(fftData);
+                    }));
+
+            AnalyzerPathGenerator<juce::Path> pathGenerator;
+            pathGenerator.setBounds(pathArea.toFloat());
+
+            juce::Path path;
+            auto binWidth = (float)(sampleRate / (double)generator.getFFTSize());
+
+            addResult(results, "analyzer/generatePath" + orderName, pathArea, numCalls,
+                timeCalls(numCalls, [&] { pathGenerator.getPath(path); },
+                    [&] { pathGenerator.generatePath(fftData, generator.getFFTSize(), binWidth, -100.f); }));
+        }
+    }
+}
+
+void runEditorBenchmarks(BenchmarkResults& results, bool quick)
+{
+    auto numCalls = quick ? 30 : 300;
+
+    runComponentBenchmarks(results, numCalls);
+    runAnalyzerBenchmarks(results, numCalls);
+}
@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    Runs the benchmarks and prints the results as JSON, or compares the
+    results of two builds.
+
+      Z-XO-EQ-Benchmarks [--processor] [--editor] [--quick] [--label=name] [--output=file.json]
+      Z-XO-EQ-Benchmarks --compare baseline.json candidate.json [--threshold=percent]
+
+    Both the processor and the editor are run unless one of them is asked
+    for. A comparison exits with the number of results that got slower by more
+    than the threshold (5 % unless given).
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+
+int main(int argc, char* argv[])
+{
+    juce::ArgumentList arguments(argc, argv);
+
+    if (arguments.containsOption("--compare"))
+    {
+        auto index = arguments.indexOfOption("--compare");
+
+        if (index + 2 >= arguments.size())
+        {
+            std::cerr << "--compare needs a baseline and a candidate file" << std::endl;
+            return 255;
+        }
+
+        auto threshold = arguments.containsOption("--threshold") ? arguments.getValueForOption("--threshold").getDoubleValue() : 5.0;
+        auto regressions = compareBenchmarks(arguments[index + 1].resolveAsFile(), arguments[index + 2].resolveAsFile(), threshold);
+
+        return regressions < 0 ? 255 : juce::jmin(regressions, 254);
+    }
+
+    // the processor's parameters and the editor need the message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    auto quick = arguments.containsOption("--quick");
+
+    auto runProcessor = arguments.containsOption("--processor") || !arguments.containsOption("--editor");
+    auto runEditor = arguments.containsOption("--editor") || !arguments.containsOption("--processor");
+
+    BenchmarkResults results;
+
+    if (runProcessor)
+        runProcessorBenchmarks(results, quick);
+
+    if (runEditor)
+        runEditorBenchmarks(results, quick);
+
+    auto json = results.toJSON(arguments.getValueForOption("--label"));
+
+    if (arguments.containsOption("--output"))
+        return arguments.getFileForOption("--output").replaceWithText(json) ? 0 : 255;
+
+    std::cout << json << std::endl;
+    return 0;
+}
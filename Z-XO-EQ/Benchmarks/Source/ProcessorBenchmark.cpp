@@ -0,0 +1,262 @@
+/*
+  ==============================================================================
+
+    Times ZXOEQAudioProcessor::processBlock on stereo noise, and the cut
+    filter cascades on their own.
+
+    The processor is swept one axis at a time around a default setting
+    (every band on, 24 dB/oct cuts, 48 kHz, 512 samples): sample rate and
+    block size together, then the slopes, the bypass combinations and the
+    filter engines, each with static and with automated parameters.
+    Automation moves the cut and parametric frequencies before every block
+    the way a host would, so the coefficient redesigns are part of the time.
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+#include "../../Source/PluginProcessor.h"
+
+namespace
+{
+    constexpr double defaultSampleRate = 48000.0;
+    constexpr int defaultBlockSize = 512;
+    constexpr int numSlopes = Slope_96dB + 1;
+
+    const double sampleRates[] = { 44100.0, 48000.0, 88200.0, 96000.0, 192000.0 };
+    const int blockSizes[] = { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+
+    struct ProcessorCase
+    {
+        juce::String name;
+        double sampleRate = defaultSampleRate;
+        int blockSize = defaultBlockSize;
+        int slope = Slope_24dB;
+        bool lowCut = true;
+        bool parametric = true;
+        bool highCut = true;
+        int engine = 0;
+        bool automated = false;
+    };
+
+    struct Timing
+    {
+        juce::int64 ticks = 0;
+        juce::int64 cycles = 0;
+        juce::int64 samples = 0;
+    };
+
+    juce::String getSlopeName(int slope)
+    {
+        return juce::String(12 * (slope + 1)) + "dB";
+    }
+
+    void setParameter(ZXOEQAudioProcessor& processor, const juce::String& id, float value)
+    {
+        auto* parameter = processor.state.getParameter(id);
+        jassert(parameter != nullptr);
+
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+
+    void fillWithNoise(juce::AudioBuffer<float>& buffer, juce::Random& random)
+    {
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample(ch, i, 0.25f * (2.f * random.nextFloat() - 1.f));
+    }
+
+    void addResult(BenchmarkResults& results, const juce::String& name, double sampleRate, int blockSize, const Timing& timing)
+    {
+        auto seconds = juce::Time::highResolutionTicksToSeconds(timing.ticks);
+        auto nsPerSample = seconds * 1.0e9 / (double)timing.samples;
+
+        juce::NamedValueSet values;
+        values.set("sampleRate", sampleRate);
+        values.set("blockSize", blockSize);
+        values.set("nsPerSample", nsPerSample);
+        values.set("realtimeFactor", ((double)timing.samples / sampleRate) / seconds);
+
+        if (hasCycleCounter)
+            values.set(juce::String(cycleCounterUnit) + "PerSample", (double)timing.cycles / (double)timing.samples);
+
+        results.add(name, values);
+        BenchmarkResults::log(name, nsPerSample, "ns/sample");
+    }
+
+    // a quarter of a second to settle, then 'seconds' of audio, only processBlock itself is timed
+    Timing timeProcessor(const ProcessorCase& c, double seconds)
+    {
+        ZXOEQAudioProcessor processor;
+
+        setParameter(processor, "LowCut Bypass", c.lowCut ? 0.f : 1.f);
+        setParameter(processor, "Parametric Bypass", c.parametric ? 0.f : 1.f);
+        setParameter(processor, "HighCut Bypass", c.highCut ? 0.f : 1.f);
+        setParameter(processor, "LowCut Slope", (float)c.slope);
+        setParameter(processor, "HighCut Slope", (float)c.slope);
+        setParameter(processor, "LowCut Frequency", 80.f);
+        setParameter(processor, "HighCut Frequency", 12000.f);
+        setParameter(processor, "Parametric Gain", 6.f);
+        setParameter(processor, "Filter Engine", (float)c.engine);
+
+        processor.setRateAndBufferSizeDetails(c.sampleRate, c.blockSize);
+        processor.prepareToPlay(c.sampleRate, c.blockSize);
+
+        juce::Random random(1);
+        juce::AudioBuffer<float> noise(2, c.blockSize);
+        juce::AudioBuffer<float> buffer(2, c.blockSize);
+        juce::MidiBuffer midi;
+
+        auto warmUpBlocks = (juce::int64)(0.25 * c.sampleRate) / c.blockSize + 1;
+        auto numBlocks = (juce::int64)(seconds * c.sampleRate) / c.blockSize + 1;
+
+        Timing timing;
+
+        for (juce::int64 block = 0; block < warmUpBlocks + numBlocks; ++block)
+        {
+            if (c.automated)
+            {
+                // a slow sweep, every block lands on new values
+                auto position = 0.5 + 0.5 * std::sin(juce::MathConstants<double>::twoPi * 0.5 * double(block * c.blockSize) / c.sampleRate);
+
+                setParameter(processor, "LowCut Frequency", (float)(40.0 + 120.0 * position));
+                setParameter(processor, "Parametric Frequency", (float)(200.0 + 4800.0 * position));
+                setParameter(processor, "HighCut Frequency", (float)(8000.0 + 8000.0 * position));
+            }
+
+            fillWithNoise(noise, random);
+            buffer.makeCopyOf(noise, true);
+
+            auto startTicks = juce::Time::getHighResolutionTicks();
+            auto startCycles = readCycleCounter();
+
+            processor.processBlock(buffer, midi);
+
+            auto endCycles = readCycleCounter();
+            auto endTicks = juce::Time::getHighResolutionTicks();
+
+            if (block >= warmUpBlocks)
+            {
+                timing.ticks += endTicks - startTicks;
+                timing.cycles += endCycles - startCycles;
+                timing.samples += c.blockSize;
+            }
+        }
+
+        processor.releaseResources();
+
+        return timing;
+    }
+
+    // the low cut cascade alone, what the processor spends on one cut filter
+    Timing timeCutCascade(CutResponse response, int slope, double seconds)
+    {
+        SectionList sections;
+        addCutSections(sections, 100.0, 2 * (slope + 1), response, true);
+
+        SectionCascade cascade;
+        cascade.setSections(sections, defaultSampleRate);
+        cascade.reset();
+
+        juce::Random random(1);
+        juce::AudioBuffer<float> noise(2, defaultBlockSize);
+        juce::AudioBuffer<float> buffer(2, defaultBlockSize);
+        fillWithNoise(noise, random);
+
+        auto numBlocks = (juce::int64)(seconds * defaultSampleRate) / defaultBlockSize + 1;
+
+        Timing timing;
+
+        for (juce::int64 block = 0; block < numBlocks; ++block)
+        {
+            buffer.makeCopyOf(noise, true);
+            juce::dsp::AudioBlock<float> audioBlock(buffer);
+
+            auto startTicks = juce::Time::getHighResolutionTicks();
+            auto startCycles = readCycleCounter();
+
+            cascade.process(audioBlock);
+
+            timing.cycles += readCycleCounter() - startCycles;
+            timing.ticks += juce::Time::getHighResolutionTicks() - startTicks;
+            timing.samples += defaultBlockSize;
+        }
+
+        return timing;
+    }
+}
+
+void runProcessorBenchmarks(BenchmarkResults& results, bool quick)
+{
+    auto seconds = quick ? 0.5 : 4.0;
+
+    std::vector<ProcessorCase> cases;
+
+    for (auto sampleRate : sampleRates)
+    {
+        for (auto blockSize : blockSizes)
+        {
+            ProcessorCase c;
+            c.name = "processor/rate=" + juce::String((int)sampleRate) + "/block=" + juce::String(blockSize);
+            c.sampleRate = sampleRate;
+            c.blockSize = blockSize;
+            cases.push_back(c);
+        }
+    }
+
+    for (auto automated : { false, true })
+    {
+        auto suffix = automated ? "/automated" : "/static";
+
+        for (int slope = 0; slope < numSlopes; ++slope)
+        {
+            ProcessorCase c;
+            c.name = "processor/slope=" + getSlopeName(slope) + suffix;
+            c.slope = slope;
+            c.automated = automated;
+            cases.push_back(c);
+        }
+
+        for (int bands = 0; bands < 8; ++bands)
+        {
+            ProcessorCase c;
+            c.lowCut = (bands & 1) != 0;
+            c.parametric = (bands & 2) != 0;
+            c.highCut = (bands & 4) != 0;
+            c.automated = automated;
+
+            juce::StringArray active;
+            if (c.lowCut) active.add("low");
+            if (c.parametric) active.add("parametric");
+            if (c.highCut) active.add("high");
+
+            c.name = "processor/bands=" + (active.isEmpty() ? juce::String("none") : active.joinIntoString("+")) + suffix;
+            cases.push_back(c);
+        }
+
+        auto engines = getFilterEngineNames();
+
+        for (int engine = 0; engine < engines.size(); ++engine)
+        {
+            ProcessorCase c;
+            c.name = "processor/engine=" + engines[engine] + suffix;
+            c.engine = engine;
+            c.automated = automated;
+            cases.push_back(c);
+        }
+    }
+
+    for (auto& c : cases)
+        addResult(results, c.name, c.sampleRate, c.blockSize, timeProcessor(c, seconds));
+
+    auto responses = getCutResponseNames();
+
+    for (int response = 0; response < responses.size(); ++response)
+    {
+        for (int slope = 0; slope < numSlopes; ++slope)
+        {
+            auto name = "cascade/" + responses[response] + "/" + getSlopeName(slope);
+            addResult(results, name, defaultSampleRate, defaultBlockSize, timeCutCascade((CutResponse)response, slope, seconds));
+        }
+    }
+}
@@ -0,0 +1,179 @@
+/*
+  ==============================================================================
+
+    A peak section whose gain follows a band limited level detector.
+
+    The detector band pass runs on a mono key at the full rate but the
+    envelope, the gain computer and the coefficient design only run once
+    every ControlInterval samples. In between the biquad coefficients are
+    ramped linearly towards the last design, so a dynamic band costs about
+    one extra biquad plus a handful of adds per sample.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <JuceHeader.h>
+#include "SectionDesign.h"
+
+struct DynamicSection
+{
+    static constexpr int MaxChannels = 2;
+    static constexpr int ControlInterval = 32;
+
+    struct Parameters
+    {
+        float frequency{ 1000.f };
+        float quality{ 1.f };
+        float gain{ 0.f };          // resting gain in dB, used while the key stays under the threshold
+        float threshold{ -20.f };   // dB
+        float ratio{ 2.f };
+        float attack{ 10.f };       // ms
+        float release{ 100.f };     // ms
+    };
+
+    void prepare(double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+        setParameters(parameters);
+        reset();
+    }
+
+    void reset()
+    {
+        for (auto* state : { &s1, &s2 })
+            state->fill(0.f);
+
+        detectorS1 = detectorS2 = 0.f;
+        keyEnergy = 0.f;
+        keyCount = 0;
+        envelope = -120.f;
+        rampRemaining = 0;
+
+        current = target = makeDigitalSection(makePeakSection(parameters.frequency, parameters.quality,
+            juce::Decibels::decibelsToGain(parameters.gain)), sampleRate);
+    }
+
+    void setParameters(const Parameters& newParameters)
+    {
+        parameters = newParameters;
+
+        detector = makeDigitalSection(makeBandPassSection(parameters.frequency, parameters.quality), sampleRate);
+
+        auto controlRate = sampleRate / ControlInterval;
+        attackCoefficient = timeToCoefficient(parameters.attack, controlRate);
+        releaseCoefficient = timeToCoefficient(parameters.release, controlRate);
+    }
+
+    /** key may be the same block as the audio, every key sample is read before the sample is filtered. */
+    void process(const juce::dsp::AudioBlock<float>& block, const juce::dsp::AudioBlock<float>& key)
+    {
+        auto numSamples = (int)block.getNumSamples();
+        auto numChannels = juce::jmin((int)block.getNumChannels(), MaxChannels);
+        auto numKeyChannels = (int)key.getNumChannels();
+
+        if (numChannels == 0 || numKeyChannels == 0)
+            return;
+
+        auto keyScale = 1.f / (float)numKeyChannels;
+
+        for (int n = 0; n < numSamples; ++n)
+        {
+            auto keySample = 0.f;
+
+            for (int ch = 0; ch < numKeyChannels; ++ch)
+                keySample += key.getSample(ch, n);
+
+            detect(keySample * keyScale);
+
+            if (rampRemaining > 0)
+            {
+                current.b0 += step.b0;
+                current.b1 += step.b1;
+                current.b2 += step.b2;
+                current.a1 += step.a1;
+                current.a2 += step.a2;
+
+                if (--rampRemaining == 0)
+                    current = target;
+            }
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto* samples = block.getChannelPointer((size_t)ch);
+                auto x = samples[n];
+
+                auto y = current.b0 * x + s1[ch];
+                s1[ch] = current.b1 * x - current.a1 * y + s2[ch];
+                s2[ch] = current.b2 * x - current.a2 * y;
+
+                samples[n] = y;
+            }
+        }
+    }
+
+private:
+    static float timeToCoefficient(float milliseconds, double rate)
+    {
+        return (float)std::exp(-1.0 / (juce::jmax(0.01, (double)milliseconds) * 0.001 * rate));
+    }
+
+    void detect(float keySample)
+    {
+        auto y = detector.b0 * keySample + detectorS1;
+        detectorS1 = detector.b1 * keySample - detector.a1 * y + detectorS2;
+        detectorS2 = detector.b2 * keySample - detector.a2 * y;
+
+        keyEnergy += y * y;
+
+        if (++keyCount == ControlInterval)
+            updateControl();
+    }
+
+    // control rate: envelope in dB, downward gain computer, then one design to ramp towards
+    void updateControl()
+    {
+        auto level = juce::Decibels::gainToDecibels(keyEnergy / (float)ControlInterval, -240.f) * 0.5f;
+
+        keyEnergy = 0.f;
+        keyCount = 0;
+
+        auto coefficient = level > envelope ? attackCoefficient : releaseCoefficient;
+        envelope = level + coefficient * (envelope - level);
+
+        auto over = envelope - parameters.threshold;
+        auto gainReduction = over > 0.f ? over * (1.f / juce::jmax(1.f, parameters.ratio) - 1.f) : 0.f;
+
+        auto gain = juce::jlimit(-30.f, 30.f, parameters.gain + gainReduction);
+
+        target = makeDigitalSection(makePeakSection(parameters.frequency, parameters.quality,
+            juce::Decibels::decibelsToGain(gain)), sampleRate);
+
+        auto scale = 1.f / (float)ControlInterval;
+        step.b0 = (target.b0 - current.b0) * scale;
+        step.b1 = (target.b1 - current.b1) * scale;
+        step.b2 = (target.b2 - current.b2) * scale;
+        step.a1 = (target.a1 - current.a1) * scale;
+        step.a2 = (target.a2 - current.a2) * scale;
+
+        rampRemaining = ControlInterval;
+    }
+
+    Parameters parameters;
+    double sampleRate = 44100.0;
+
+    SectionCoefficients current, target, step, detector;
+    std::array<float, MaxChannels> s1{}, s2{};
+
+    float detectorS1 = 0.f, detectorS2 = 0.f;
+    float keyEnergy = 0.f;
+    int keyCount = 0;
+
+    float attackCoefficient = 0.f, releaseCoefficient = 0.f;
+    float envelope = -120.f;
+
+    int rampRemaining = 0;
+};
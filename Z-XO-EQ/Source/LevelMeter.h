@@ -0,0 +1,188 @@
+/*
+  ==============================================================================
+
+    Peak, RMS and true peak levels of a block, measured on the audio thread
+    and published through atomics.
+
+    Peaks are held until the editor reads them, so no block between two
+    frames is missed. The RMS is a running mean square over about 300 ms.
+    The true peak is the sample peak of the block oversampled four times.
+    It costs an oversampler, so it only runs while something asks for it.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <JuceHeader.h>
+
+// Sum of the squared samples, four or eight at a time once the pointer is aligned
+inline float sumOfSquares(const float* data, int numSamples) noexcept
+{
+    auto sum = 0.f;
+    int i = 0;
+
+   #if JUCE_USE_SIMD
+    using Register = juce::dsp::SIMDRegister<float>;
+    constexpr auto registerSize = (int)Register::SIMDNumElements;
+
+    for (; i < numSamples && !Register::isSIMDAligned(data + i); ++i)
+        sum += data[i] * data[i];
+
+    auto accumulator = Register::expand(0.f);
+
+    for (; i + registerSize <= numSamples; i += registerSize)
+    {
+        auto samples = Register::fromRawArray(data + i);
+        accumulator += samples * samples;
+    }
+
+    sum += accumulator.sum();
+   #endif
+
+    for (; i < numSamples; ++i)
+        sum += data[i] * data[i];
+
+    return sum;
+}
+
+struct LevelMeter
+{
+    static constexpr int MaxChannels = 2;
+    static constexpr double RmsTimeSeconds = 0.3;
+
+    struct Reading
+    {
+        std::array<float, MaxChannels> peak{};
+        std::array<float, MaxChannels> rms{};
+        std::array<float, MaxChannels> truePeak{};
+        int numChannels = 0;
+    };
+
+    /** withTruePeak sets up the oversampler, allocates, so not from the audio thread. */
+    void prepare(double newSampleRate, int maximumBlockSize, bool withTruePeak)
+    {
+        sampleRate = newSampleRate;
+
+        if (withTruePeak)
+        {
+            oversampling = std::make_unique<juce::dsp::Oversampling<float>>(MaxChannels, 2,
+                juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple, false);
+            oversamplingBlockSize = juce::jmax(1, maximumBlockSize);
+            oversampling->initProcessing((size_t)oversamplingBlockSize);
+        }
+        else
+        {
+            oversampling.reset();
+        }
+
+        truePeakRunning = false;
+
+        for (auto& meanSquare : meanSquares)
+            meanSquare = 0.f;
+
+        for (auto* levels : { &peaks, &rmsLevels, &truePeaks })
+            for (auto& level : *levels)
+                level.store(0.f);
+    }
+
+    // audio thread only
+    void measure(const juce::dsp::AudioBlock<const float>& block) noexcept
+    {
+        auto numChannels = juce::jmin((int)block.getNumChannels(), MaxChannels);
+        auto numSamples = (int)block.getNumSamples();
+
+        if (numSamples == 0 || sampleRate <= 0.0)
+            return;
+
+        numMeasuredChannels.store(numChannels, std::memory_order_relaxed);
+
+        auto smoothing = 1.f - (float)std::exp(-double(numSamples) / (RmsTimeSeconds * sampleRate));
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* data = block.getChannelPointer((size_t)ch);
+
+            auto range = juce::FloatVectorOperations::findMinAndMax(data, numSamples);
+            hold(peaks[(size_t)ch], juce::jmax(-range.getStart(), range.getEnd()));
+
+            auto& meanSquare = meanSquares[(size_t)ch];
+            meanSquare += (sumOfSquares(data, numSamples) / (float)numSamples - meanSquare) * smoothing;
+            rmsLevels[(size_t)ch].store(std::sqrt(meanSquare), std::memory_order_relaxed);
+        }
+
+        if (oversampling == nullptr || !truePeakActive.load(std::memory_order_relaxed))
+        {
+            truePeakRunning = false;
+            return;
+        }
+
+        // the filters still hold whatever they saw when the meter was last shown
+        if (!truePeakRunning)
+        {
+            oversampling->reset();
+            truePeakRunning = true;
+        }
+
+        // the oversampler only has room for the block size it was prepared with, hosts may hand over more
+        auto channels = block.getSubsetChannelBlock(0, (size_t)numChannels);
+
+        for (int start = 0; start < numSamples; start += oversamplingBlockSize)
+        {
+            auto length = juce::jmin(oversamplingBlockSize, numSamples - start);
+            auto oversampled = oversampling->processSamplesUp(channels.getSubBlock((size_t)start, (size_t)length));
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto range = juce::FloatVectorOperations::findMinAndMax(oversampled.getChannelPointer((size_t)ch), (int)oversampled.getNumSamples());
+                hold(truePeaks[(size_t)ch], juce::jmax(-range.getStart(), range.getEnd()));
+            }
+        }
+    }
+
+    /** The peaks since the last call and the current RMS, as gains. */
+    Reading read() noexcept
+    {
+        Reading reading;
+        reading.numChannels = numMeasuredChannels.load(std::memory_order_relaxed);
+
+        for (int ch = 0; ch < MaxChannels; ++ch)
+        {
+            reading.peak[(size_t)ch] = peaks[(size_t)ch].exchange(0.f, std::memory_order_relaxed);
+            reading.rms[(size_t)ch] = rmsLevels[(size_t)ch].load(std::memory_order_relaxed);
+            reading.truePeak[(size_t)ch] = truePeaks[(size_t)ch].exchange(0.f, std::memory_order_relaxed);
+        }
+
+        return reading;
+    }
+
+    bool hasTruePeak() const noexcept { return oversampling != nullptr; }
+
+    // set by whoever shows the true peak, nothing is oversampled while it is off
+    std::atomic<bool> truePeakActive{ false };
+
+private:
+    // a reader resetting the level between the load and the store only drops a value no larger than the one it read
+    static void hold(std::atomic<float>& level, float value) noexcept
+    {
+        if (value > level.load(std::memory_order_relaxed))
+            level.store(value, std::memory_order_relaxed);
+    }
+
+    double sampleRate = 0.0;
+
+    std::unique_ptr<juce::dsp::Oversampling<float>> oversampling;
+    int oversamplingBlockSize = 1;
+    bool truePeakRunning = false;
+
+    std::array<float, MaxChannels> meanSquares{};
+
+    std::array<std::atomic<float>, MaxChannels> peaks{};
+    std::array<std::atomic<float>, MaxChannels> rmsLevels{};
+    std::array<std::atomic<float>, MaxChannels> truePeaks{};
+    std::atomic<int> numMeasuredChannels{ 0 };
+};
@@ -0,0 +1,214 @@
+/*
+  ==============================================================================
+
+    ITU-R BS.1770 / EBU R 128 loudness of a stream: momentary (400 ms),
+    short-term (3 s) and integrated.
+
+    The K-weighted signal is summed in 100 ms steps. Both windows are
+    running sums over the last steps, each step is added once and taken
+    away once, so the cost per sample is the weighting and one square.
+    Every step also closes a 400 ms gating block (75% overlap). Those go
+    into a histogram of 0.1 LU bins that keeps the power of each bin, so
+    the gated integrated loudness needs bounded memory however long the
+    stream runs.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <JuceHeader.h>
+#include "SectionCascade.h"
+#include "LevelMeter.h"
+
+struct LoudnessMeter
+{
+    static constexpr int MaxChannels = SectionCascade::MaxChannels;
+
+    static constexpr int MomentarySteps = 4;
+    static constexpr int ShortTermSteps = 30;
+
+    static constexpr double AbsoluteGate = -70.0;
+    static constexpr double RelativeGate = -10.0;
+    static constexpr double BinsPerLU = 10.0;
+    static constexpr int NumBins = 800;
+
+    // reported until a window has been filled, and for silence
+    static constexpr float MinimumLoudness = -100.f;
+
+    /** Allocates, so not from the audio thread. */
+    void prepare(double sampleRate, int maximumBlockSize)
+    {
+        SectionList weighting;
+        addKWeightingSections(weighting);
+
+        kWeighting.setSections(weighting, sampleRate);
+        kWeighting.reset();
+
+        weighted.setSize(MaxChannels, juce::jmax(1, maximumBlockSize));
+
+        stepLength = juce::jmax(1, juce::roundToInt(0.1 * sampleRate));
+        stepPosition = 0;
+        stepSum = 0.0;
+
+        stepPowers.fill(0.0);
+        nextStep = 0;
+        numSteps = 0;
+        momentarySum = 0.0;
+        shortTermSum = 0.0;
+
+        momentary.store(MinimumLoudness);
+        shortTerm.store(MinimumLoudness);
+
+        resetIntegrated();
+        resetRequested.store(false);
+    }
+
+    // audio thread only
+    void measure(const juce::dsp::AudioBlock<const float>& block) noexcept
+    {
+        if (resetRequested.exchange(false))
+            resetIntegrated();
+
+        auto numChannels = juce::jmin((int)block.getNumChannels(), MaxChannels);
+        auto numSamples = (int)block.getNumSamples();
+
+        // hosts may hand over more than they announced, the weighting runs through the scratch buffer in pieces
+        for (int start = 0; start < numSamples; start += weighted.getNumSamples())
+        {
+            auto length = juce::jmin(weighted.getNumSamples(), numSamples - start);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                juce::FloatVectorOperations::copy(weighted.getWritePointer(ch), block.getChannelPointer((size_t)ch) + start, length);
+
+            auto weightedBlock = juce::dsp::AudioBlock<float>(weighted).getSubsetChannelBlock(0, (size_t)numChannels).getSubBlock(0, (size_t)length);
+            kWeighting.process(weightedBlock);
+
+            for (int position = 0; position < length;)
+            {
+                auto count = juce::jmin(length - position, stepLength - stepPosition);
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                    stepSum += sumOfSquares(weighted.getReadPointer(ch) + position, count);
+
+                position += count;
+                stepPosition += count;
+
+                if (stepPosition == stepLength)
+                    finishStep();
+            }
+        }
+    }
+
+    float getMomentary() const noexcept { return momentary.load(std::memory_order_relaxed); }
+    float getShortTerm() const noexcept { return shortTerm.load(std::memory_order_relaxed); }
+    float getIntegrated() const noexcept { return integrated.load(std::memory_order_relaxed); }
+
+    // starts the integrated loudness over, taken up by the audio thread on its next block
+    void requestReset() noexcept { resetRequested.store(true); }
+
+private:
+    // channel weights are 1 for left and right, so the power is the sum of their mean squares
+    static double toLoudness(double power) noexcept
+    {
+        return power > 0.0 ? -0.691 + 10.0 * std::log10(power) : (double)MinimumLoudness;
+    }
+
+    void finishStep() noexcept
+    {
+        auto power = stepSum / (double)stepLength;
+
+        stepSum = 0.0;
+        stepPosition = 0;
+
+        // the step leaving the short-term window sits where the new one goes, the one leaving the momentary window four before it
+        auto leavingMomentary = stepPowers[(size_t)((nextStep + ShortTermSteps - MomentarySteps) % ShortTermSteps)];
+
+        momentarySum = juce::jmax(0.0, momentarySum + power - leavingMomentary);
+        shortTermSum = juce::jmax(0.0, shortTermSum + power - stepPowers[(size_t)nextStep]);
+
+        stepPowers[(size_t)nextStep] = power;
+        nextStep = (nextStep + 1) % ShortTermSteps;
+        numSteps = juce::jmin(numSteps + 1, ShortTermSteps);
+
+        if (numSteps >= MomentarySteps)
+        {
+            auto blockPower = momentarySum / MomentarySteps;
+
+            momentary.store((float)toLoudness(blockPower), std::memory_order_relaxed);
+            addGatingBlock(blockPower);
+        }
+
+        if (numSteps >= ShortTermSteps)
+            shortTerm.store((float)toLoudness(shortTermSum / ShortTermSteps), std::memory_order_relaxed);
+    }
+
+    void addGatingBlock(double power) noexcept
+    {
+        auto loudness = toLoudness(power);
+
+        if (loudness <= AbsoluteGate)
+            return;
+
+        auto bin = juce::jlimit(0, NumBins - 1, (int)((loudness - AbsoluteGate) * BinsPerLU));
+
+        ++binCounts[(size_t)bin];
+        binPowers[(size_t)bin] += power;
+
+        ++gatedCount;
+        gatedPower += power;
+
+        // the relative gate sits 10 LU under everything that passed the absolute one,
+        // only whole bins above it are counted
+        auto relativeThreshold = toLoudness(gatedPower / (double)gatedCount) + RelativeGate;
+        auto firstBin = juce::jlimit(0, NumBins, (int)std::ceil((relativeThreshold - AbsoluteGate) * BinsPerLU));
+
+        juce::int64 count = 0;
+        double sum = 0.0;
+
+        for (int i = firstBin; i < NumBins; ++i)
+        {
+            count += binCounts[(size_t)i];
+            sum += binPowers[(size_t)i];
+        }
+
+        if (count > 0)
+            integrated.store((float)toLoudness(sum / (double)count), std::memory_order_relaxed);
+    }
+
+    void resetIntegrated() noexcept
+    {
+        binCounts.fill(0);
+        binPowers.fill(0.0);
+        gatedCount = 0;
+        gatedPower = 0.0;
+
+        integrated.store(MinimumLoudness);
+    }
+
+    SectionCascade kWeighting;
+    juce::AudioBuffer<float> weighted;
+
+    int stepLength = 1;
+    int stepPosition = 0;
+    double stepSum = 0.0;
+
+    std::array<double, ShortTermSteps> stepPowers{};
+    int nextStep = 0;
+    int numSteps = 0;
+    double momentarySum = 0.0;
+    double shortTermSum = 0.0;
+
+    std::array<juce::int64, NumBins> binCounts{};
+    std::array<double, NumBins> binPowers{};
+    juce::int64 gatedCount = 0;
+    double gatedPower = 0.0;
+
+    std::atomic<float> momentary{ MinimumLoudness };
+    std::atomic<float> shortTerm{ MinimumLoudness };
+    std::atomic<float> integrated{ MinimumLoudness };
+    std::atomic<bool> resetRequested{ false };
+};
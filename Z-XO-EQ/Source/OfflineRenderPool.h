@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+    A thread pool shared by every instance in the process, for offline renders.
+
+    It is opt-in: ZXOEQ_OFFLINE_THREADS sets the number of worker threads and
+    without it no threads are started at all. Jobs of one run are claimed from
+    a shared counter, so whichever thread is free takes the next one and the
+    calling thread works through them as well instead of only waiting. Jobs no
+    worker got to before the caller finished are taken back off the queue.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <JuceHeader.h>
+
+struct OfflineRenderPool
+{
+    // helpers queued per run, any number of jobs is shared out between them and the calling thread
+    static constexpr int MaxHelpers = 15;
+
+    OfflineRenderPool()
+    {
+        auto numThreads = juce::SystemStats::getEnvironmentVariable("ZXOEQ_OFFLINE_THREADS", {}).getIntValue();
+
+        if (numThreads > 0)
+            pool = std::make_unique<juce::ThreadPool>(juce::jmin(numThreads, juce::SystemStats::getNumCpus()));
+    }
+
+    bool isEnabled() const { return pool != nullptr; }
+
+    /** Calls job(0) ... job(numJobs - 1) spread over the pool and the calling thread, returns once all are done. */
+    void run(int numJobs, const std::function<void(int)>& job)
+    {
+        if (pool == nullptr || numJobs <= 1)
+        {
+            for (int i = 0; i < numJobs; ++i)
+                job(i);
+
+            return;
+        }
+
+        std::atomic<int> nextJob{ 0 };
+
+        auto work = [&]()
+        {
+            for (int i = nextJob.fetch_add(1); i < numJobs; i = nextJob.fetch_add(1))
+                job(i);
+        };
+
+        std::array<Helper, MaxHelpers> helpers;
+        auto numHelpers = juce::jmin(numJobs - 1, MaxHelpers);
+
+        for (int i = 0; i < numHelpers; ++i)
+        {
+            helpers[(size_t)i].work = work;
+            pool->addJob(&helpers[(size_t)i], false);
+        }
+
+        work();
+
+        // a helper that never started is dropped, one that is running is waited for
+        for (int i = 0; i < numHelpers; ++i)
+            pool->removeJob(&helpers[(size_t)i], false, -1);
+    }
+
+private:
+    struct Helper : juce::ThreadPoolJob
+    {
+        Helper() : juce::ThreadPoolJob("ZXOEQ offline render") {}
+
+        JobStatus runJob() override
+        {
+            work();
+            return jobHasFinished;
+        }
+
+        std::function<void()> work;
+    };
+
+    std::unique_ptr<juce::ThreadPool> pool;
+};
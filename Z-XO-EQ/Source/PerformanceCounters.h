@@ -0,0 +1,235 @@
+/*
+  ==============================================================================
+
+    Lightweight realtime counters for processBlock. Everything is written
+    from the audio thread with relaxed atomics and read from anywhere.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <JuceHeader.h>
+
+#if JUCE_MSVC
+ #include <intrin.h>
+#elif JUCE_INTEL
+ #include <x86intrin.h>
+#endif
+
+// arm64 has no user readable cycle counter, the generic timer ticks at a fixed rate instead (24 MHz on Apple silicon),
+// so the counts are labelled with what they are, cycles or timer ticks, and the short form for the editor
+#if JUCE_INTEL
+ constexpr bool hasCycleCounter = true;
+ constexpr const char* cycleCounterUnit = "cycles";
+ constexpr const char* cycleCounterShortUnit = "cyc";
+#elif JUCE_ARM && JUCE_64BIT
+ constexpr bool hasCycleCounter = true;
+ constexpr const char* cycleCounterUnit = "ticks";
+ constexpr const char* cycleCounterShortUnit = "ticks";
+#else
+ constexpr bool hasCycleCounter = false;
+ constexpr const char* cycleCounterUnit = "";
+ constexpr const char* cycleCounterShortUnit = "";
+#endif
+
+inline juce::int64 readCycleCounter() noexcept
+{
+   #if JUCE_INTEL
+    return (juce::int64)__rdtsc();
+   #elif JUCE_ARM && JUCE_64BIT && JUCE_MSVC
+    return (juce::int64)_ReadStatusReg(ARM64_CNTVCT);
+   #elif JUCE_ARM && JUCE_64BIT
+    juce::uint64 ticks;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+    return (juce::int64)ticks;
+   #else
+    return 0;
+   #endif
+}
+
+struct PerformanceCounters
+{
+    // 10% wide buckets of block time relative to the block deadline, the last one collects overruns
+    static constexpr int NumLoadBuckets = 11;
+
+    struct Snapshot
+    {
+        juce::int64 numBlocks = 0;
+        juce::int64 numSamples = 0;
+        juce::int64 totalCycles = 0;
+        juce::int64 worstBlockCycles = 0;
+        juce::int64 coefficientRedesigns = 0;
+        juce::int64 silentBlocks = 0;
+
+        double averageLoad = 0.0;
+        double lastLoad = 0.0;
+        double worstLoad = 0.0;
+        double worstBlockSeconds = 0.0;
+
+        std::array<juce::int64, NumLoadBuckets> loadHistogram{};
+
+        // in cycleCounterUnit
+        double getCyclesPerSample() const { return numSamples > 0 ? double(totalCycles) / double(numSamples) : 0.0; }
+    };
+
+    /** Times one block from construction to destruction. */
+    struct ScopedBlockTimer
+    {
+        ScopedBlockTimer(PerformanceCounters& c, int blockSize) noexcept : counters(c), numSamples(blockSize) {}
+
+        ~ScopedBlockTimer()
+        {
+            counters.addBlock(juce::Time::getHighResolutionTicks() - startTicks, readCycleCounter() - startCycles, numSamples);
+        }
+
+    private:
+        PerformanceCounters& counters;
+        int numSamples;
+        juce::int64 startTicks = juce::Time::getHighResolutionTicks();
+        juce::int64 startCycles = readCycleCounter();
+    };
+
+    void prepare(double newSampleRate)
+    {
+        sampleRate.store(newSampleRate);
+        reset();
+    }
+
+    void reset()
+    {
+        numBlocks.store(0);
+        numSamples.store(0);
+        totalTicks.store(0);
+        totalCycles.store(0);
+        worstBlockTicks.store(0);
+        worstBlockCycles.store(0);
+        coefficientRedesigns.store(0);
+        silentBlocks.store(0);
+        lastLoad.store(0.0);
+        worstLoad.store(0.0);
+
+        for (auto& bucket : loadHistogram)
+            bucket.store(0);
+    }
+
+    // audio thread only, there is a single writer so plain load/store pairs are enough
+    void addBlock(juce::int64 elapsedTicks, juce::int64 elapsedCycles, int blockSize) noexcept
+    {
+        auto rate = sampleRate.load(std::memory_order_relaxed);
+
+        if (blockSize <= 0 || rate <= 0.0)
+            return;
+
+        auto deadline = double(blockSize) / rate;
+        auto load = juce::Time::highResolutionTicksToSeconds(elapsedTicks) / deadline;
+        auto bucket = juce::jlimit(0, NumLoadBuckets - 1, (int)(load * 10.0));
+
+        increment(loadHistogram[bucket], 1);
+        increment(numBlocks, 1);
+        increment(numSamples, blockSize);
+        increment(totalTicks, elapsedTicks);
+        increment(totalCycles, elapsedCycles);
+
+        lastLoad.store(load, std::memory_order_relaxed);
+
+        if (elapsedTicks > worstBlockTicks.load(std::memory_order_relaxed))
+            worstBlockTicks.store(elapsedTicks, std::memory_order_relaxed);
+
+        if (elapsedCycles > worstBlockCycles.load(std::memory_order_relaxed))
+            worstBlockCycles.store(elapsedCycles, std::memory_order_relaxed);
+
+        if (load > worstLoad.load(std::memory_order_relaxed))
+            worstLoad.store(load, std::memory_order_relaxed);
+    }
+
+    void coefficientsRedesigned() noexcept { increment(coefficientRedesigns, 1); }
+
+    // a block that was skipped because the input was silent and the filters had rung out
+    void blockSkipped() noexcept { increment(silentBlocks, 1); }
+
+    Snapshot getSnapshot() const
+    {
+        Snapshot s;
+        s.numBlocks = numBlocks.load(std::memory_order_relaxed);
+        s.numSamples = numSamples.load(std::memory_order_relaxed);
+        s.totalCycles = totalCycles.load(std::memory_order_relaxed);
+        s.worstBlockCycles = worstBlockCycles.load(std::memory_order_relaxed);
+        s.coefficientRedesigns = coefficientRedesigns.load(std::memory_order_relaxed);
+        s.silentBlocks = silentBlocks.load(std::memory_order_relaxed);
+        s.lastLoad = lastLoad.load(std::memory_order_relaxed);
+        s.worstLoad = worstLoad.load(std::memory_order_relaxed);
+        s.worstBlockSeconds = juce::Time::highResolutionTicksToSeconds(worstBlockTicks.load(std::memory_order_relaxed));
+
+        auto rate = sampleRate.load(std::memory_order_relaxed);
+
+        if (s.numSamples > 0 && rate > 0.0)
+            s.averageLoad = juce::Time::highResolutionTicksToSeconds(totalTicks.load(std::memory_order_relaxed)) / (double(s.numSamples) / rate);
+
+        for (int i = 0; i < NumLoadBuckets; ++i)
+            s.loadHistogram[i] = loadHistogram[i].load(std::memory_order_relaxed);
+
+        return s;
+    }
+
+    juce::String toString() const
+    {
+        auto s = getSnapshot();
+
+        juce::String text;
+        text << "sample rate: " << sampleRate.load() << "\n";
+        text << "blocks: " << s.numBlocks << "\n";
+        text << "samples: " << s.numSamples << "\n";
+
+        if (hasCycleCounter)
+            text << "cycles per sample: " << s.getCyclesPerSample() << "\n";
+
+        text << "average load: " << s.averageLoad * 100.0 << " %\n";
+        text << "worst load: " << s.worstLoad * 100.0 << " %\n";
+        text << "worst block: " << s.worstBlockSeconds * 1000.0 << " ms";
+
+        if (hasCycleCounter)
+            text << " (" << s.worstBlockCycles << " cycles)";
+
+        text << "\n";
+        text << "coefficient redesigns: " << s.coefficientRedesigns << "\n";
+        text << "silent blocks skipped: " << s.silentBlocks << "\n";
+        text << "load histogram:\n";
+
+        for (int i = 0; i < NumLoadBuckets; ++i)
+        {
+            if (i < NumLoadBuckets - 1)
+                text << "  " << (i * 10) << "-" << ((i + 1) * 10) << " %: ";
+            else
+                text << "  overrun: ";
+
+            text << s.loadHistogram[i] << "\n";
+        }
+
+        return text;
+    }
+
+private:
+    static void increment(std::atomic<juce::int64>& counter, juce::int64 amount) noexcept
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    std::atomic<double> sampleRate{ 0.0 };
+
+    std::atomic<juce::int64> numBlocks{ 0 };
+    std::atomic<juce::int64> numSamples{ 0 };
+    std::atomic<juce::int64> totalTicks{ 0 };
+    std::atomic<juce::int64> totalCycles{ 0 };
+    std::atomic<juce::int64> worstBlockTicks{ 0 };
+    std::atomic<juce::int64> worstBlockCycles{ 0 };
+    std::atomic<juce::int64> coefficientRedesigns{ 0 };
+    std::atomic<juce::int64> silentBlocks{ 0 };
+
+    std::atomic<double> lastLoad{ 0.0 };
+    std::atomic<double> worstLoad{ 0.0 };
+
+    std::array<std::atomic<juce::int64>, NumLoadBuckets> loadHistogram{};
+};
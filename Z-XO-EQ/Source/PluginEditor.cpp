@@ -139,6 +139,11 @@ juce::String RotarySliderWithLabels::getDisplayString() const {
         string << suffix;
     }
 
+    if (suffix == "ms" || suffix == ":1") {
+
+        string << suffix;
+    }
+
 
     return string;
 }
@@ -206,7 +211,9 @@ juce::Rectangle<int> RotarySliderWithLabels::getSliderBounds() const {
 ResponseCurveComponent::ResponseCurveComponent(ZXOEQAudioProcessor& p) : 
     audioProcessor(p),
 leftChannelFifo(&audioProcessor.leftChannelFifo),
-rightChannelFifo(&audioProcessor.rightChannelFifo) {
+rightChannelFifo(&audioProcessor.rightChannelFifo),
+inputLeftChannelFifo(&audioProcessor.inputLeftChannelFifo),
+inputRightChannelFifo(&audioProcessor.inputRightChannelFifo) {
     const auto& parameters = audioProcessor.getParameters();
     for (auto parameter : parameters) {
         parameter->addListener(this);
@@ -218,13 +225,28 @@ rightChannelFifo(&audioProcessor.rightChannelFifo) {
     rightChannelFFTDataGenerator.changeOrder(FFTOrder::order2048);
     monoBufferR.setSize(1,rightChannelFFTDataGenerator.getFFTSize());
 
+    inputLeftChannelFFTDataGenerator.changeOrder(FFTOrder::order2048);
+    inputMonoBufferL.setSize(1, inputLeftChannelFFTDataGenerator.getFFTSize());
+
+    inputRightChannelFFTDataGenerator.changeOrder(FFTOrder::order2048);
+    inputMonoBufferR.setSize(1, inputRightChannelFFTDataGenerator.getFFTSize());
+
+    // the grid image covers every pixel, so nothing behind needs repainting with it
+    setOpaque(true);
+
+    updateRenderer();
     updateChain();
 
-    startTimerHz(60);
+    vBlankAttachment = juce::VBlankAttachment(this, [this]() { vBlankCallback(); });
 
 }
 
 ResponseCurveComponent::~ResponseCurveComponent() {
+    openGLContext.detach();
+
+    // nobody is left to read the input tap
+    audioProcessor.inputTapActive.store(false);
+
     const auto& parameters = audioProcessor.getParameters();
     for (auto parameter : parameters) {
         parameter->removeListener(this);
@@ -238,244 +260,480 @@ void ResponseCurveComponent::parameterValueChanged(int parameterIndex, float new
     shouldUpdateParameters.set(true);
 }
 
-void ResponseCurveComponent::timerCallback() {
+double ResponseCurveComponent::getFrameRate() {
 
-    const auto fftBounds = getAnalysisArea().toFloat();
-    juce::AudioBuffer<float> temporaryIncomingBufferL;
-    juce::AudioBuffer<float> temporaryIncomingBufferR;
+    auto cap = getFrameRateCaps()[(int)audioProcessor.state.getRawParameterValue("Display Frame Rate")->load()];
 
-    // LEFT
+    auto* peer = getPeer();
 
-    while (leftChannelFifo->getNumCompleteBuffersAvailable() > 0) {
-        
-        
-        if (leftChannelFifo->getAudioBuffer(temporaryIncomingBufferL)) {
-            auto sizeL = temporaryIncomingBufferL.getNumSamples();
+    if (!isShowing() || peer == nullptr || peer->isMinimised()) {
+        return juce::jmin(cap, HiddenFrameRate);
+    }
 
-            juce::FloatVectorOperations::copy(monoBufferL.getWritePointer(0, 0), monoBufferL.getReadPointer(0, sizeL), monoBufferL.getNumSamples() - sizeL);
+    if (framesWithoutChange >= FramesUntilStatic) {
+        return juce::jmin(cap, StaticFrameRate);
+    }
 
-            juce::FloatVectorOperations::copy(monoBufferL.getWritePointer(0, monoBufferL.getNumSamples() - sizeL), temporaryIncomingBufferL.getReadPointer(0, 0), sizeL);
+    return cap;
+}
 
-            leftChannelFFTDataGenerator.produceFFTDataForRendering(monoBufferL, -100.f);
-        }
+void ResponseCurveComponent::vBlankCallback() {
+
+    auto now = juce::Time::getMillisecondCounterHiRes();
+
+    // a little slack, vertical blanks don't arrive exactly one interval apart
+    if (now - lastFrameTime < 1000.0 / getFrameRate() - 2.0) {
+        return;
     }
 
+    lastFrameTime = now;
+
+    if (updateFrame()) {
+        framesWithoutChange = 0;
+    }
+    else {
+        ++framesWithoutChange;
+    }
+}
+
+bool ResponseCurveComponent::updateFrame() {
+
+    auto spectrogramWanted = audioProcessor.state.getRawParameterValue("Analyzer View")->load() > 0.5f;
+
+    // only a new path or column, new parameters or another view make the frame any different from the last one
+    bool analysisChanged = spectrogramWanted != showSpectrogram;
+    showSpectrogram = spectrogramWanted;
+
+    // the input is only tapped while it is shown, on its own or in the difference
+    auto source = (int)audioProcessor.state.getRawParameterValue("Analyzer Source")->load();
+    audioProcessor.inputTapActive.store(source != Source_Output);
+
+    auto sourceChanged = source != analyzerSource;
+    analyzerSource = source;
+
+    // the taps restarted together, what is left of the input from before the restart is stale
+    auto inputTapRestarts = audioProcessor.inputTapRestarts.load();
+
+    if (inputTapRestarts != inputTapRestartsSeen) {
+        inputTapRestartsSeen = inputTapRestarts;
+        inputMonoBufferL.clear();
+        inputMonoBufferR.clear();
+        sourceChanged = true;
+    }
+
+    auto negativeInfinity = analyzerSource == Source_Difference ? -2.f * DifferenceRange : -100.f;
+
+    // both channels are drained before any frame is taken, so the frames below can go in pairs
+    pullAnalyzerTap(*leftChannelFifo, monoBufferL, leftChannelFFTDataGenerator, analyzerSource != Source_Input);
+    pullAnalyzerTap(*inputLeftChannelFifo, inputMonoBufferL, inputLeftChannelFFTDataGenerator, analyzerSource != Source_Output);
+    pullAnalyzerTap(*rightChannelFifo, monoBufferR, rightChannelFFTDataGenerator, analyzerSource != Source_Input);
+    pullAnalyzerTap(*inputRightChannelFifo, inputMonoBufferR, inputRightChannelFFTDataGenerator, analyzerSource != Source_Output);
+
     // bin width = 48000 / 8192 = 5.85hz
     
     const auto fftSizeL = leftChannelFFTDataGenerator.getFFTSize();
     const auto binWidthL = audioProcessor.getSampleRate() / (double)fftSizeL;
+    const auto fftSizeR = rightChannelFFTDataGenerator.getFFTSize();
+    const auto binWidthR = audioProcessor.getSampleRate() / (double)fftSizeR;
+
+    // frames from before a switch would pair the wrong moments of output and input
+    if (sourceChanged) {
+        discardFFTData(leftChannelFFTDataGenerator);
+        discardFFTData(inputLeftChannelFFTDataGenerator);
+        discardFFTData(rightChannelFFTDataGenerator);
+        discardFFTData(inputRightChannelFFTDataGenerator);
+        analysisChanged = true;
+    }
+
+    std::vector<float> fftDataL;
+    std::vector<float> fftDataR;
 
+    // One frame of each channel per pass, so a spectrogram column has the left and right of the same moment.
+    // Both taps are fed by the same blocks, a channel that is a frame short only happens around a restart.
+    for (;;) {
 
-    while (leftChannelFFTDataGenerator.getNumAvailableFFTDataBlocks() > 0) {
+        auto hasLeft = pullAnalyzerFrame(leftChannelFFTDataGenerator, inputLeftChannelFFTDataGenerator, fftDataL);
+        auto hasRight = pullAnalyzerFrame(rightChannelFFTDataGenerator, inputRightChannelFFTDataGenerator, fftDataR);
 
-        std::vector<float> fftDataL;
-        if (leftChannelFFTDataGenerator.getFFTData(fftDataL)) {
-            pathProducerL.generatePath(fftDataL, fftBounds, fftSizeL, binWidthL, -100.f);
+        if (!hasLeft && !hasRight)
+            break;
+
+        if (showSpectrogram) {
+
+            // without a right frame of its own the column takes the last one
+            if (hasRight)
+                latestFFTDataR = fftDataR;
+
+            if (hasLeft) {
+                ScopedTraceSpan columnSpan(audioProcessor.traceRecorder, TraceRecorder::MessageThread, "spectrogram column");
+                spectrogram.addColumn(fftDataL, latestFFTDataR, fftSizeL, binWidthL, negativeInfinity);
+                analysisChanged = true;
+            }
         }
+        else {
+            ScopedTraceSpan pathSpan(audioProcessor.traceRecorder, TraceRecorder::MessageThread, "path generation");
+
+            if (hasLeft)
+                pathProducerL.generatePath(fftDataL, fftSizeL, binWidthL, negativeInfinity);
 
+            if (hasRight)
+                pathProducerR.generatePath(fftDataR, fftSizeR, binWidthR, negativeInfinity);
+        }
     }
 
     while (pathProducerL.getNumPathsAvailable()) {
 
         pathProducerL.getPath(LeftChannelFFTPath);
+        analysisChanged = true;
     }
 
-    // RIGHT
+    while (pathProducerR.getNumPathsAvailable()) {
 
-    while (rightChannelFifo->getNumCompleteBuffersAvailable() > 0) {
+        pathProducerR.getPath(RightChannelFFTPath);
+        analysisChanged = true;
+    }
 
 
-        if (rightChannelFifo->getAudioBuffer(temporaryIncomingBufferR)) {
-            auto sizeR = temporaryIncomingBufferR.getNumSamples();
-            
-            juce::FloatVectorOperations::copy(monoBufferR.getWritePointer(0,0), monoBufferR.getReadPointer(0, sizeR), monoBufferR.getNumSamples() - sizeR);
 
-            juce::FloatVectorOperations::copy(monoBufferR.getWritePointer(0, monoBufferR.getNumSamples() - sizeR), temporaryIncomingBufferR.getReadPointer(0, 0), sizeR);
+    if (shouldUpdateParameters.compareAndSetBool(false, true)) {
 
-            rightChannelFFTDataGenerator.produceFFTDataForRendering(monoBufferR, -100.f);
-        }
+        updateRenderer();
+        updateChain();
+        analysisChanged = true;
     }
 
-    // bin width = 48000 / 8192 = 5.85hz
+    if (analysisChanged) {
+        repaint(getAnalysisArea());
+    }
 
+    // the counters only need a few updates a second, and only their own corner
+    auto now = juce::Time::getMillisecondCounterHiRes();
 
-    const auto fftSizeR = rightChannelFFTDataGenerator.getFFTSize();
-    const auto binWidthR = audioProcessor.getSampleRate() / (double)fftSizeR;
+    if (now - lastPerformanceUpdate >= PerformanceUpdateInterval) {
 
+        lastPerformanceUpdate = now;
 
-    while (rightChannelFFTDataGenerator.getNumAvailableFFTDataBlocks() > 0) {
+        auto text = makePerformanceText();
 
-        std::vector<float> fftDataR;
-        if (rightChannelFFTDataGenerator.getFFTData(fftDataR)) {
-            pathProducerR.generatePath(fftDataR, fftBounds, fftSizeR, binWidthR, -100.f);
+        if (text != performanceText) {
+            performanceText = text;
+            repaint(getPerformanceArea());
         }
 
+        auto loudness = makeLoudnessText();
+
+        if (loudness != loudnessText) {
+            loudnessText = loudness;
+            repaint(getLoudnessArea());
+        }
     }
 
-    while (pathProducerR.getNumPathsAvailable()) {
+    return analysisChanged;
+}
 
-        pathProducerR.getPath(RightChannelFFTPath);
+void ResponseCurveComponent::updateRenderer() {
+
+    auto wanted = audioProcessor.state.getRawParameterValue("OpenGL Rendering")->load() > 0.5f && !openGLUnavailable;
+
+    if (wanted && !openGLContext.isAttached()) {
+
+        openGLContext.setRenderer(this);
+        openGLContext.setComponentPaintingEnabled(true);
+        openGLContext.attachTo(*this);
+    }
+    else if (!wanted && openGLContext.isAttached()) {
+
+        openGLContext.detach();
     }
+}
 
+// GL thread. A software driver (llvmpipe, SwiftShader, GDI Generic) is slower than our own rasteriser,
+// so the context is dropped again and this editor stays on the software path.
+void ResponseCurveComponent::newOpenGLContextCreated() {
 
+    auto* rendererName = reinterpret_cast<const char*>(juce::gl::glGetString(juce::gl::GL_RENDERER));
+    auto renderer = juce::String(rendererName != nullptr ? rendererName : "");
 
-    if (shouldUpdateParameters.compareAndSetBool(false, true)) {
+    juce::StringArray softwareRenderers{ "llvmpipe", "softpipe", "SwiftShader", "GDI Generic", "Software" };
 
-        updateChain();
+    auto isSoftware = renderer.isEmpty();
+
+    for (const auto& name : softwareRenderers) {
+        isSoftware = isSoftware || renderer.containsIgnoreCase(name);
+    }
 
+    if (isSoftware) {
 
+        juce::MessageManager::callAsync([safePointer = juce::Component::SafePointer<ResponseCurveComponent>(this)]() {
+            if (safePointer != nullptr) {
+                safePointer->openGLUnavailable = true;
+                safePointer->updateRenderer();
+            }
+        });
     }
-    
-    repaint();
+}
+
+void ResponseCurveComponent::renderOpenGL() {
+
+    juce::OpenGLHelpers::clear(juce::Colours::black);
 }
 
 void ResponseCurveComponent::updateChain(){
 
     auto chainParameters = getChainParameters(audioProcessor.state);
 
-    MonoChain.setBypassed<ChainLocations::LowCut>(chainParameters.lowCutBypass);
-    MonoChain.setBypassed<ChainLocations::HighCut>(chainParameters.highCutBypass);
-    MonoChain.setBypassed<ChainLocations::Parametric>(chainParameters.parametricBypass);
+    SectionList sections;
+    makeChainSections(chainParameters, sections);
 
+    channelsAreLinked = true;
 
+    for (auto& channelSections : responseSections) {
+        channelSections.clear();
+    }
 
-    auto parametricCoefficients = makeParametricFilter(chainParameters, audioProcessor.getSampleRate());
+    for (int i = 0; i < sections.size; ++i) {
 
-    updateCoefficients(MonoChain.get<ChainLocations::Parametric>().coefficients, parametricCoefficients);
+        auto coefficients = makeDigitalSection(sections.sections[i], audioProcessor.getSampleRate());
 
+        for (int ch = 0; ch < SectionCascade::MaxChannels; ++ch) {
+            if (sections.appliesToChannel(i, ch)) {
+                responseSections[ch].push_back(coefficients);
+            }
+        }
 
-    auto lowCutCoefficients = makeLowCutFilter(chainParameters, audioProcessor.getSampleRate());
-    auto highCutCoefficients = makeHighCutFilter(chainParameters, audioProcessor.getSampleRate());
+        channelsAreLinked = channelsAreLinked && sections.channels[i] == AllChannels;
+    }
 
-    updateCutFilter(MonoChain.get<ChainLocations::LowCut>(), lowCutCoefficients, chainParameters.lowCutSlope);
-    updateCutFilter(MonoChain.get<ChainLocations::HighCut>(), highCutCoefficients, chainParameters.highCutSlope);
+    renderResponseCurves();
 }
 
-void ResponseCurveComponent::paint (juce::Graphics & g){
-        // (Our component is opaque, so we must completely fill the background with a solid colour)
-        g.fillAll(juce::Colours::grey);
+// The curves go into a layer of their own that is only redrawn here, paint just puts it on top
+void ResponseCurveComponent::renderResponseCurves() {
 
-        g.drawImage(background, getLocalBounds().toFloat());
-        
+        if (getWidth() <= 0 || getHeight() <= 0) {
+            return;
+        }
 
+        ScopedTraceSpan curveSpan(audioProcessor.traceRecorder, TraceRecorder::MessageThread, "response curve");
+
+        curveLayer = makeLayer(juce::Image::PixelFormat::ARGB);
+        juce::Graphics g(curveLayer);
+        g.addTransform(juce::AffineTransform::scale(layerScale));
 
         auto visualResponse = getAnalysisArea();
 
         auto width = visualResponse.getWidth();
 
-        auto& lowCutChain = MonoChain.get<ChainLocations::LowCut>();
-        auto& highCutChain = MonoChain.get<ChainLocations::HighCut>();
-        auto& parametricChain = MonoChain.get<ChainLocations::Parametric>();
-
         auto sampleRate = audioProcessor.getSampleRate();
 
+        const double min = visualResponse.getBottom();
+        const double max = visualResponse.getY();
 
-
+        auto map = [min, max](double input) {
+            return juce::jmap(input, -30.0, 30.0, min, max);
+        };
 
         std::vector<double> magnitudes;
         magnitudes.resize(width);
 
-        for (auto i = 0; i < width; ++i) {
-            double magnitude = 1.f;
-            auto frequency = juce::mapToLog10(double(i) / double(width), 20.0, 20000.0);
+        auto makeResponseCurve = [&](const std::vector<SectionCoefficients>& channelSections) {
 
+            for (auto i = 0; i < width; ++i) {
+                double magnitude = 1.f;
+                auto frequency = juce::mapToLog10(double(i) / double(width), 20.0, 20000.0);
 
-            if (!MonoChain.isBypassed<ChainLocations::Parametric>()) {
-                magnitude *= parametricChain.coefficients->getMagnitudeForFrequency(frequency, sampleRate);
-            }
+                for (const auto& section : channelSections) {
+                    magnitude *= getMagnitudeForFrequency(section, frequency, sampleRate);
+                }
 
-            if (! MonoChain.isBypassed<ChainLocations::LowCut>()) {
+                magnitudes[i] = juce::Decibels::gainToDecibels(magnitude);
+            }
 
-                if (!lowCutChain.isBypassed<0>()) {
-                    magnitude *= lowCutChain.get<0>().coefficients->getMagnitudeForFrequency(frequency, sampleRate);
-                }
-                if (!lowCutChain.isBypassed<1>()) {
-                    magnitude *= lowCutChain.get<1>().coefficients->getMagnitudeForFrequency(frequency, sampleRate);
-                }
-                if (!lowCutChain.isBypassed<2>()) {
-                    magnitude *= lowCutChain.get<2>().coefficients->getMagnitudeForFrequency(frequency, sampleRate);
-                }
-                if (!lowCutChain.isBypassed<3>()) {
-                    magnitude *= lowCutChain.get<3>().coefficients->getMagnitudeForFrequency(frequency, sampleRate);
-                }
+            juce::Path curve;
+            curve.startNewSubPath(visualResponse.getX(), map(magnitudes.front()));
 
+            for (size_t x = 1; x < magnitudes.size(); ++x) {
+                curve.lineTo(visualResponse.getX() + x, map(magnitudes[x]));
             }
 
-            if (! MonoChain.isBypassed<ChainLocations::HighCut>()) {
+            return curve;
+        };
 
-                if (!highCutChain.isBypassed<0>()) {
-                    magnitude *= highCutChain.get<0>().coefficients->getMagnitudeForFrequency(frequency, sampleRate);
-                }
-                if (!highCutChain.isBypassed<1>()) {
-                    magnitude *= highCutChain.get<1>().coefficients->getMagnitudeForFrequency(frequency, sampleRate);
-                }
-                if (!highCutChain.isBypassed<2>()) {
-                    magnitude *= highCutChain.get<2>().coefficients->getMagnitudeForFrequency(frequency, sampleRate);
-                }
-                if (!highCutChain.isBypassed<3>()) {
-                    magnitude *= highCutChain.get<3>().coefficients->getMagnitudeForFrequency(frequency, sampleRate);
-                }
+        // right or side channel underneath the first one
+        if (!channelsAreLinked) {
+            g.setColour(juce::Colours::orange);
+            g.strokePath(makeResponseCurve(responseSections[1]), juce::PathStrokeType(2.f));
+        }
 
-            }
-            magnitudes[i] = juce::Decibels::gainToDecibels(magnitude);
+        g.setColour(juce::Colours::yellow);
+        g.strokePath(makeResponseCurve(responseSections[0]), juce::PathStrokeType(2.5f));
+    }
+
+void ResponseCurveComponent::pullAnalyzerTap(SingleChannelSampleFifo<ZXOEQAudioProcessor::BlockType>& fifo,
+    juce::AudioBuffer<float>& monoBuffer,
+    FFTDataGenerator<std::vector<float>>& generator,
+    bool analyze) {
+
+    juce::AudioBuffer<float> temporaryIncomingBuffer;
+
+    while (fifo.getNumCompleteBuffersAvailable() > 0) {
 
+        if (fifo.getAudioBuffer(temporaryIncomingBuffer)) {
+            auto size = temporaryIncomingBuffer.getNumSamples();
 
+            juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, 0), monoBuffer.getReadPointer(0, size), monoBuffer.getNumSamples() - size);
 
+            juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, monoBuffer.getNumSamples() - size), temporaryIncomingBuffer.getReadPointer(0, 0), size);
+
+            // a tap that is not shown keeps its window current, but is not analysed
+            if (analyze) {
+                ScopedTraceSpan fftSpan(audioProcessor.traceRecorder, TraceRecorder::MessageThread, "FFT");
+                generator.produceFFTDataForRendering(monoBuffer, -100.f);
+            }
         }
+    }
+}
 
-        juce::Path responseCurve;
+bool ResponseCurveComponent::pullAnalyzerFrame(FFTDataGenerator<std::vector<float>>& output,
+    FFTDataGenerator<std::vector<float>>& input,
+    std::vector<float>& frame) {
 
-        const double min = visualResponse.getBottom();
-        const double max = visualResponse.getY();
+    if (analyzerSource == Source_Output)
+        return output.getFFTData(frame);
 
-        auto map = [min, max](double input) {
-            return juce::jmap(input, -30.0, 30.0, min, max);
-        };
+    if (analyzerSource == Source_Input)
+        return input.getFFTData(frame);
 
-        responseCurve.startNewSubPath(visualResponse.getX(), map(magnitudes.front()));
+    // both spectra are already in decibels, so the difference is a subtraction, moved onto the
+    // response curve's scale with 0 dB in the middle
+    if (output.getNumAvailableFFTDataBlocks() == 0 || input.getNumAvailableFFTDataBlocks() == 0)
+        return false;
 
-        for (size_t x = 1; x < magnitudes.size(); ++x) {
-            responseCurve.lineTo(visualResponse.getX() + x, map(magnitudes[x]));
-        }
+    output.getFFTData(frame);
+    input.getFFTData(inputFFTData);
 
-        auto xAxis = visualResponse.getX() - 6;
-        auto yAxis = visualResponse.getY() - 11;
+    auto numBins = output.getFFTSize() / 2;
 
-        
+    juce::FloatVectorOperations::subtract(frame.data(), inputFFTData.data(), numBins);
+    juce::FloatVectorOperations::add(frame.data(), -DifferenceRange, numBins);
+    juce::FloatVectorOperations::clip(frame.data(), frame.data(), -2.f * DifferenceRange, 0.f, numBins);
 
+    return true;
+}
 
-        LeftChannelFFTPath.applyTransform(juce::AffineTransform().translation(visualResponse.getX(), yAxis));
+void ResponseCurveComponent::discardFFTData(FFTDataGenerator<std::vector<float>>& generator) {
 
+    while (generator.getNumAvailableFFTDataBlocks() > 0)
+        generator.getFFTData(inputFFTData);
+}
 
-        g.setColour(juce::Colours::green);
-        g.strokePath(LeftChannelFFTPath, juce::PathStrokeType(1.f));
-   
+void ResponseCurveComponent::paint (juce::Graphics & g){
+        ScopedTraceSpan paintSpan(audioProcessor.traceRecorder, TraceRecorder::MessageThread, "paint");
 
-        RightChannelFFTPath.applyTransform(juce::AffineTransform().translation(visualResponse.getX(), yAxis));
-        
-        g.setColour(juce::Colours::purple);
-        g.strokePath(RightChannelFFTPath, juce::PathStrokeType(1.f));
+        // Layers from the bottom: the grid from resized(), the analyzer, the response curves from
+        // renderResponseCurves() and the counters. Only the spectrum is drawn from scratch here.
+        // moved to a display of another density, the layers are drawn again for it
+        if (juce::Component::getApproximateScaleFactorForComponent(this) != layerScale) {
+            resized();
+        }
+
+        drawLayer(g, background);
+
+        if (showSpectrogram) {
+            spectrogram.draw(g);
+        }
+        else {
+            // the analyzer paths come in component coordinates, see resized()
+            g.setColour(juce::Colours::green);
+            g.strokePath(LeftChannelFFTPath, juce::PathStrokeType(1.f));
+
+            g.setColour(juce::Colours::purple);
+            g.strokePath(RightChannelFFTPath, juce::PathStrokeType(1.f));
+        }
 
-        
         g.setColour(juce::Colours::ghostwhite);
         g.drawRoundedRectangle(getAnalysisArea().toFloat(), 2.f, 2.f);
 
-        g.setColour(juce::Colours::yellow);
-        g.strokePath(responseCurve, juce::PathStrokeType(2.5f));
+        drawLayer(g, curveLayer);
+
+        const int fontHeight = 10;
+        g.setFont(fontHeight);
+
+        g.setColour(juce::Colours::ghostwhite);
+        g.drawFittedText(performanceText, getPerformanceArea(), juce::Justification::centredRight, 1);
+        g.drawFittedText(loudnessText, getLoudnessArea(), juce::Justification::centredLeft, 1);
+    }
+
+juce::Image ResponseCurveComponent::makeLayer(juce::Image::PixelFormat format) const {
+
+        return juce::Image(format, juce::jmax(1, juce::roundToInt(getWidth() * layerScale)),
+                           juce::jmax(1, juce::roundToInt(getHeight() * layerScale)), true);
+    }
+
+void ResponseCurveComponent::drawLayer(juce::Graphics& g, const juce::Image& layer) const {
+
+        g.drawImageTransformed(layer, juce::AffineTransform::scale(1.f / layerScale));
+    }
+
+juce::String ResponseCurveComponent::makePerformanceText() {
 
+        auto counters = audioProcessor.performanceCounters.getSnapshot();
 
+        juce::String text;
+        text << "CPU " << juce::String(counters.lastLoad * 100.0, 1) << "%";
+        text << "  avg " << juce::String(counters.averageLoad * 100.0, 1) << "%";
+        text << "  worst " << juce::String(counters.worstBlockSeconds * 1000.0, 2) << " ms";
 
+        if (hasCycleCounter)
+            text << "  " << juce::String(counters.getCyclesPerSample(), 0) << " " << cycleCounterShortUnit << "/smp";
+
+        text << "  redesigns " << counters.coefficientRedesigns;
+
+        return text;
+    }
+
+juce::Rectangle<int> ResponseCurveComponent::getPerformanceArea() {
+
+        return getAnalysisArea().reduced(4, 4).removeFromBottom(10);
     }
 
+juce::String ResponseCurveComponent::makeLoudnessText() {
+
+        auto& meter = audioProcessor.loudnessMeter;
+
+        auto format = [](float loudness) {
+            return loudness > LoudnessMeter::MinimumLoudness ? juce::String(loudness, 1) : juce::String("-inf");
+        };
+
+        juce::String text;
+        text << "M " << format(meter.getMomentary());
+        text << "  S " << format(meter.getShortTerm());
+        text << "  I " << format(meter.getIntegrated()) << " LUFS";
+
+        return text;
+    }
+
+juce::Rectangle<int> ResponseCurveComponent::getLoudnessArea() {
+
+        return getPerformanceArea().removeFromLeft(200);
+    }
 
 void ResponseCurveComponent::resized() {
 
-  
+        // analyzer paths are generated straight into the analysis area, the ones made for the old size are dropped
+        pathProducerL.setBounds(getAnalysisArea().toFloat());
+        pathProducerR.setBounds(getAnalysisArea().toFloat());
 
-        background = juce::Image(juce::Image::PixelFormat::RGB, getWidth(), getHeight(), true);
-        
- 
+        LeftChannelFFTPath.clear();
+        RightChannelFFTPath.clear();
+
+        spectrogram.setBounds(getAnalysisArea());
+
+        layerScale = juce::Component::getApproximateScaleFactorForComponent(this);
+
+        background = makeLayer(juce::Image::PixelFormat::RGB);
         juce::Graphics g(background);
+        g.addTransform(juce::AffineTransform::scale(layerScale));
 
         juce::Array<float> frequencies{ 
         
@@ -583,7 +841,7 @@ void ResponseCurveComponent::resized() {
 
             juce::Rectangle<int> r;
             r.setSize(textWidth, dbFont);
-            r.setX(getWidth() - textWidth - 725);
+            r.setX(left + 60 - textWidth);
             r.setCentre(r.getCentreX(), normY);
 
             g.setColour(gain == 0 ? juce::Colour(0u, 172u, 1u) : juce::Colours::yellow);
@@ -595,7 +853,7 @@ void ResponseCurveComponent::resized() {
 
         }
 
-
+        renderResponseCurves();
     }
 
 juce::Rectangle<int> ResponseCurveComponent::getRenderArea() {
@@ -631,6 +889,116 @@ juce::Rectangle<int> ResponseCurveComponent::getAnalysisArea() {
 
 
 //==============================================================================
+LevelMeterComponent::LevelMeterComponent(ZXOEQAudioProcessor& p) : audioProcessor(p) {
+
+    setOpaque(true);
+
+    vBlankAttachment = juce::VBlankAttachment(this, [this]() { vBlankCallback(); });
+}
+
+LevelMeterComponent::~LevelMeterComponent() {
+
+    audioProcessor.outputMeter.truePeakActive.store(false);
+}
+
+void LevelMeterComponent::vBlankCallback() {
+
+    audioProcessor.outputMeter.truePeakActive.store(isShowing());
+
+    auto now = juce::Time::getMillisecondCounterHiRes();
+    auto elapsedSeconds = (now - lastFrameTime) / 1000.0;
+
+    if (elapsedSeconds < 1.0 / FrameRate)
+        return;
+
+    lastFrameTime = now;
+
+    auto outputReading = audioProcessor.outputMeter.read();
+
+    auto previousInput = input;
+    auto previousOutput = output;
+    auto previousTruePeakHold = truePeakHold;
+
+    update(input, audioProcessor.inputMeter.read(), elapsedSeconds);
+    update(output, outputReading, elapsedSeconds);
+
+    for (int ch = 0; ch < outputReading.numChannels; ++ch)
+        truePeakHold = juce::jmax(truePeakHold, juce::Decibels::gainToDecibels(outputReading.truePeak[(size_t)ch], MinimumDecibels));
+
+    // in silence, once the peaks have fallen, the meter stays as it is painted
+    if (input != previousInput || output != previousOutput || truePeakHold != previousTruePeakHold)
+        repaint();
+}
+
+void LevelMeterComponent::update(Levels& levels, const LevelMeter::Reading& reading, double elapsedSeconds) {
+
+    auto peak = 0.f;
+    auto rms = 0.f;
+
+    for (int ch = 0; ch < reading.numChannels; ++ch) {
+        peak = juce::jmax(peak, reading.peak[(size_t)ch]);
+        rms = juce::jmax(rms, reading.rms[(size_t)ch]);
+    }
+
+    // peaks jump up and fall back slowly, the RMS is already smoothed
+    auto fallenPeak = levels.peak - PeakDecayPerSecond * (float)elapsedSeconds;
+
+    levels.peak = juce::jmax(fallenPeak, juce::Decibels::gainToDecibels(peak, MinimumDecibels), MinimumDecibels);
+    levels.rms = juce::Decibels::gainToDecibels(rms, MinimumDecibels);
+}
+
+void LevelMeterComponent::mouseDown(const juce::MouseEvent& event) {
+
+    truePeakHold = MinimumDecibels;
+    audioProcessor.loudnessMeter.requestReset();
+    repaint();
+}
+
+void LevelMeterComponent::drawBar(juce::Graphics& g, juce::Rectangle<float> area, const juce::String& label, const Levels& levels) {
+
+    g.setColour(juce::Colours::lightgrey);
+    g.drawFittedText(label, area.removeFromLeft(30.f).toNearestInt(), juce::Justification::centredLeft, 1);
+
+    g.setColour(juce::Colours::darkslategrey);
+    g.fillRect(area);
+
+    auto toX = [area](float decibels) {
+        return juce::jmap(juce::jlimit(MinimumDecibels, MaximumDecibels, decibels), MinimumDecibels, MaximumDecibels, area.getX(), area.getRight());
+    };
+
+    g.setColour(levels.rms > 0.f ? juce::Colours::red : juce::Colours::limegreen);
+    g.fillRect(area.withRight(toX(levels.rms)));
+
+    g.setColour(levels.peak > 0.f ? juce::Colours::red : juce::Colours::ghostwhite);
+    g.fillRect(juce::Rectangle<float>(toX(levels.peak) - 1.f, area.getY(), 2.f, area.getHeight()));
+
+    // 0 dBFS
+    g.setColour(juce::Colours::dimgrey);
+    g.drawVerticalLine(juce::roundToInt(toX(0.f)), area.getY(), area.getBottom());
+}
+
+void LevelMeterComponent::paint(juce::Graphics& g) {
+
+    g.fillAll(juce::Colours::black);
+
+    auto bounds = getLocalBounds().toFloat();
+
+    auto truePeakArea = bounds.removeFromRight(90.f);
+
+    g.setFont(bounds.getHeight() / 2.f);
+
+    auto inputArea = bounds.removeFromTop(bounds.getHeight() / 2.f).reduced(0.f, 1.f);
+    auto outputArea = bounds.reduced(0.f, 1.f);
+
+    drawBar(g, inputArea, "IN", input);
+    drawBar(g, outputArea, "OUT", output);
+
+    auto truePeakText = truePeakHold > MinimumDecibels ? juce::String(truePeakHold, 1) + " dBTP" : juce::String("-inf dBTP");
+
+    g.setColour(truePeakHold > 0.f ? juce::Colours::red : juce::Colours::lightgrey);
+    g.drawFittedText(truePeakText, truePeakArea.toNearestInt(), juce::Justification::centredRight, 1);
+}
+
 ZXOEQAudioProcessorEditor::ZXOEQAudioProcessorEditor(ZXOEQAudioProcessor& p)
     : AudioProcessorEditor(&p), audioProcessor(p),
     parametricFrequencySlider(*audioProcessor.state.getParameter("Parametric Frequency"), "Hz"),
@@ -656,7 +1024,27 @@ ZXOEQAudioProcessorEditor::ZXOEQAudioProcessorEditor(ZXOEQAudioProcessor& p)
     lowCutBypassButtonAttachment(audioProcessor.state, "LowCut Bypass", lowCutBypassButton),
     highCutBypassButtonAttachment(audioProcessor.state, "HighCut Bypass", highCutBypassButton),
     parametricBypassButtonAttachment(audioProcessor.state, "Parametric Bypass", parametricBypassButton),
-    analyzerEnableButtonAttachment(audioProcessor.state, "Analyzer Enabled", analyzerEnableButton)
+    analyzerEnableButtonAttachment(audioProcessor.state, "Analyzer Enabled", analyzerEnableButton),
+    autoGainButtonAttachment(audioProcessor.state, "Auto Gain", autoGainButton),
+    automationRampButtonAttachment(audioProcessor.state, "Automation Ramp", automationRampButton),
+    levelMeter(audioProcessor),
+    openGLButtonAttachment(audioProcessor.state, "OpenGL Rendering", openGLButton),
+
+    parametricThresholdSlider(*audioProcessor.state.getParameter("Parametric Threshold"), "dB"),
+    parametricRatioSlider(*audioProcessor.state.getParameter("Parametric Ratio"), ":1"),
+    parametricAttackSlider(*audioProcessor.state.getParameter("Parametric Attack"), "ms"),
+    parametricReleaseSlider(*audioProcessor.state.getParameter("Parametric Release"), "ms"),
+
+    parametricDynamicButtonAttachment(audioProcessor.state, "Parametric Dynamic", parametricDynamicButton),
+    parametricSidechainButtonAttachment(audioProcessor.state, "Parametric Sidechain", parametricSidechainButton),
+    parametricThresholdSliderAttachment(audioProcessor.state, "Parametric Threshold", parametricThresholdSlider),
+    parametricRatioSliderAttachment(audioProcessor.state, "Parametric Ratio", parametricRatioSlider),
+    parametricAttackSliderAttachment(audioProcessor.state, "Parametric Attack", parametricAttackSlider),
+    parametricReleaseSliderAttachment(audioProcessor.state, "Parametric Release", parametricReleaseSlider),
+
+    bandFrequencySlider(*audioProcessor.state.getParameter(getBandParameterIDs()[0].frequency), "Hz"),
+    bandGainSlider(*audioProcessor.state.getParameter(getBandParameterIDs()[0].gain), "dB"),
+    bandQualitySlider(*audioProcessor.state.getParameter(getBandParameterIDs()[0].quality), "")
 
 {
 
@@ -676,10 +1064,31 @@ ZXOEQAudioProcessorEditor::ZXOEQAudioProcessorEditor(ZXOEQAudioProcessor& p)
     highCutFrequencySlider.labels.add({ 1.f , "20kHz" });
 
     lowCutSlopeSlider.labels.add({ 0.f , "12 dB/Oct" });
-    lowCutSlopeSlider.labels.add({ 1.f , "48 dB/Oct" });
+    lowCutSlopeSlider.labels.add({ 1.f , "96 dB/Oct" });
 
     highCutSlopeSlider.labels.add({ 0.f , "12 dB/Oct" });
-    highCutSlopeSlider.labels.add({ 1.f , "48 dB/Oct" });
+    highCutSlopeSlider.labels.add({ 1.f , "96 dB/Oct" });
+
+    parametricThresholdSlider.labels.add({ 0.f , "-60dB" });
+    parametricThresholdSlider.labels.add({ 1.f , "0dB" });
+
+    parametricRatioSlider.labels.add({ 0.f , "1:1" });
+    parametricRatioSlider.labels.add({ 1.f , "20:1" });
+
+    parametricAttackSlider.labels.add({ 0.f , "0.1ms" });
+    parametricAttackSlider.labels.add({ 1.f , "200ms" });
+
+    parametricReleaseSlider.labels.add({ 0.f , "5ms" });
+    parametricReleaseSlider.labels.add({ 1.f , "2s" });
+
+    bandFrequencySlider.labels.add({ 0.f , "20Hz" });
+    bandFrequencySlider.labels.add({ 1.f , "20kHz" });
+
+    bandGainSlider.labels.add({ 0.f , "-30dB" });
+    bandGainSlider.labels.add({ 1.f , "30dB" });
+
+    bandQualitySlider.labels.add({ 0.f , "0.1" });
+    bandQualitySlider.labels.add({ 1.f , "15" });
 
 
     addAndMakeVisible(parametricFrequencySlider);
@@ -692,6 +1101,9 @@ ZXOEQAudioProcessorEditor::ZXOEQAudioProcessorEditor(ZXOEQAudioProcessor& p)
     addAndMakeVisible(lowCutSlopeSlider);
     addAndMakeVisible(highCutSlopeSlider);
 
+    addAndMakeVisible(lowCutResponseSelector);
+    addAndMakeVisible(highCutResponseSelector);
+
     addAndMakeVisible(responseCurveComponent);
 
     addAndMakeVisible(lowCutBypassButton);
@@ -699,10 +1111,41 @@ ZXOEQAudioProcessorEditor::ZXOEQAudioProcessorEditor(ZXOEQAudioProcessor& p)
     addAndMakeVisible(parametricBypassButton);
     addAndMakeVisible(analyzerEnableButton);
 
+    addAndMakeVisible(processingModeSelector);
+    addAndMakeVisible(filterEngineSelector);
+    addAndMakeVisible(autoGainButton);
+    addAndMakeVisible(automationRampButton);
+    addAndMakeVisible(analyzerSourceSelector);
+    addAndMakeVisible(analyzerViewSelector);
+    addAndMakeVisible(frameRateSelector);
+    addAndMakeVisible(openGLButton);
+    addAndMakeVisible(levelMeter);
+
+    addAndMakeVisible(captureReferenceButton);
+    addAndMakeVisible(captureInputButton);
+    addAndMakeVisible(matchButton);
+
+    addAndMakeVisible(parametricDynamicButton);
+    addAndMakeVisible(parametricSidechainButton);
+    addAndMakeVisible(parametricThresholdSlider);
+    addAndMakeVisible(parametricRatioSlider);
+    addAndMakeVisible(parametricAttackSlider);
+    addAndMakeVisible(parametricReleaseSlider);
+
+    addAndMakeVisible(bandSelector);
+    addAndMakeVisible(bandTypeSelector);
+    addAndMakeVisible(bandSlopeSelector);
+    addAndMakeVisible(bandChannelSelector);
+    addAndMakeVisible(bandFrequencySlider);
+    addAndMakeVisible(bandGainSlider);
+    addAndMakeVisible(bandQualitySlider);
+    addAndMakeVisible(bandBypassButton);
+
 
     parametricBypassButton.setLookAndFeel(&LookNF);
     lowCutBypassButton.setLookAndFeel(&LookNF);
     highCutBypassButton.setLookAndFeel(&LookNF);
+    bandBypassButton.setLookAndFeel(&LookNF);
 
 
     auto safePointer = juce::Component::SafePointer<ZXOEQAudioProcessorEditor>(this);
@@ -714,6 +1157,7 @@ ZXOEQAudioProcessorEditor::ZXOEQAudioProcessorEditor(ZXOEQAudioProcessor& p)
             component->parametricFrequencySlider.setEnabled(!bypass);
             component->parametricGainSlider.setEnabled(!bypass);
             component->parametricQualitySlider.setEnabled(!bypass);
+            component->updateDynamicsControlsEnablement();
         }
     };
 
@@ -722,6 +1166,7 @@ ZXOEQAudioProcessorEditor::ZXOEQAudioProcessorEditor(ZXOEQAudioProcessor& p)
             auto bypass = component->lowCutBypassButton.getToggleState();
 
             component->lowCutSlopeSlider.setEnabled(!bypass);
+            component->lowCutResponseSelector.setEnabled(!bypass);
             component->lowCutFrequencySlider.setEnabled(!bypass);
         }
     };
@@ -731,20 +1176,194 @@ ZXOEQAudioProcessorEditor::ZXOEQAudioProcessorEditor(ZXOEQAudioProcessor& p)
             auto bypass = component->highCutBypassButton.getToggleState();
 
             component->highCutSlopeSlider.setEnabled(!bypass);
+            component->highCutResponseSelector.setEnabled(!bypass);
             component->highCutFrequencySlider.setEnabled(!bypass);
         }
     };
 
 
+    captureReferenceButton.onClick = [safePointer]() {
+        if (auto* component = safePointer.getComponent()) {
+            component->toggleCapture(SpectrumMatch::CaptureReference);
+        }
+    };
+
+    captureInputButton.onClick = [safePointer]() {
+        if (auto* component = safePointer.getComponent()) {
+            component->toggleCapture(SpectrumMatch::CaptureInput);
+        }
+    };
+
+    matchButton.onClick = [safePointer]() {
+        if (auto* component = safePointer.getComponent()) {
+            component->audioProcessor.getSpectrumMatch().setCaptureTarget(SpectrumMatch::CaptureNone);
+            component->audioProcessor.applySpectrumMatch();
+            component->updateCaptureButtons();
+        }
+    };
+
+    updateCaptureButtons();
+
+    parametricDynamicButton.onClick = [safePointer]() {
+        if (auto* component = safePointer.getComponent()) {
+            component->updateDynamicsControlsEnablement();
+        }
+    };
+
+    updateDynamicsControlsEnablement();
+
+    bandBypassButton.onClick = [safePointer]() {
+        if (auto* component = safePointer.getComponent()) {
+            component->updateBandControlsEnablement();
+        }
+    };
+
+    for (int i = 0; i < MaxBands; ++i) {
+        bandSelector.addItem("Band " + juce::String(i + 1), i + 1);
+    }
+
+    bandTypeSelector.addItemList(getBandTypeNames(), 1);
+
+    if (auto* slope = dynamic_cast<juce::AudioParameterChoice*>(audioProcessor.state.getParameter(getBandParameterIDs()[0].slope))) {
+        bandSlopeSelector.addItemList(slope->choices, 1);
+    }
+
+    bandChannelSelector.addItemList(getBandChannelNames(), 1);
+
+    // the items have to be there before the attachment picks the current one
+    processingModeSelector.addItemList(getProcessingModeNames(), 1);
+    processingModeSelectorAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.state, "Processing Mode", processingModeSelector);
+
+    analyzerSourceSelector.addItemList(getAnalyzerSourceNames(), 1);
+    analyzerSourceSelectorAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.state, "Analyzer Source", analyzerSourceSelector);
+
+    analyzerViewSelector.addItemList(getAnalyzerViewNames(), 1);
+    analyzerViewSelectorAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.state, "Analyzer View", analyzerViewSelector);
+
+    frameRateSelector.addItemList(getFrameRateNames(), 1);
+    frameRateSelectorAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.state, "Display Frame Rate", frameRateSelector);
+
+    filterEngineSelector.addItemList(getFilterEngineNames(), 1);
+    filterEngineSelectorAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.state, "Filter Engine", filterEngineSelector);
+
+    lowCutResponseSelector.addItemList(getCutResponseNames(), 1);
+    lowCutResponseSelectorAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.state, "LowCut Response", lowCutResponseSelector);
+
+    highCutResponseSelector.addItemList(getCutResponseNames(), 1);
+    highCutResponseSelectorAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.state, "HighCut Response", highCutResponseSelector);
+
+    bandTypeSelector.onChange = [safePointer]() {
+        if (auto* component = safePointer.getComponent()) {
+            component->updateBandControlsEnablement();
+        }
+    };
+
+    bandSelector.onChange = [safePointer]() {
+        if (auto* component = safePointer.getComponent()) {
+            component->showBand(component->bandSelector.getSelectedItemIndex());
+        }
+    };
+
+    bandSelector.setSelectedItemIndex(0, juce::dontSendNotification);
+    showBand(0);
 
+    // The rows of controls keep their height, the response curve and the knobs share whatever is left.
+    // The top rows need the full width of 800.
+    setResizable(true, true);
+    setResizeLimits(800, 800, 1600, 1400);
     setSize (800, 900);
 }
 
+void ZXOEQAudioProcessorEditor::showBand(int bandIndex)
+{
+    if (!juce::isPositiveAndBelow(bandIndex, MaxBands))
+        return;
+
+    // the old attachments have to let go of the controls before new ones take over
+    bandTypeSelectorAttachment.reset();
+    bandSlopeSelectorAttachment.reset();
+    bandChannelSelectorAttachment.reset();
+    bandFrequencySliderAttachment.reset();
+    bandGainSliderAttachment.reset();
+    bandQualitySliderAttachment.reset();
+    bandBypassButtonAttachment.reset();
+
+    const auto& ids = getBandParameterIDs()[bandIndex];
+    auto& state = audioProcessor.state;
+
+    bandFrequencySlider.setAudioParameter(*state.getParameter(ids.frequency));
+    bandGainSlider.setAudioParameter(*state.getParameter(ids.gain));
+    bandQualitySlider.setAudioParameter(*state.getParameter(ids.quality));
+
+    using APVTS = juce::AudioProcessorValueTreeState;
+
+    bandTypeSelectorAttachment = std::make_unique<APVTS::ComboBoxAttachment>(state, ids.type, bandTypeSelector);
+    bandSlopeSelectorAttachment = std::make_unique<APVTS::ComboBoxAttachment>(state, ids.slope, bandSlopeSelector);
+    bandChannelSelectorAttachment = std::make_unique<APVTS::ComboBoxAttachment>(state, ids.channel, bandChannelSelector);
+    bandFrequencySliderAttachment = std::make_unique<APVTS::SliderAttachment>(state, ids.frequency, bandFrequencySlider);
+    bandGainSliderAttachment = std::make_unique<APVTS::SliderAttachment>(state, ids.gain, bandGainSlider);
+    bandQualitySliderAttachment = std::make_unique<APVTS::SliderAttachment>(state, ids.quality, bandQualitySlider);
+    bandBypassButtonAttachment = std::make_unique<APVTS::ButtonAttachment>(state, ids.bypass, bandBypassButton);
+
+    updateBandControlsEnablement();
+}
+
+// Starting a capture throws away the previous one of the same kind
+void ZXOEQAudioProcessorEditor::toggleCapture(SpectrumMatch::CaptureTarget target)
+{
+    auto& spectrumMatch = audioProcessor.getSpectrumMatch();
+
+    if (spectrumMatch.getCaptureTarget() == target) {
+        spectrumMatch.setCaptureTarget(SpectrumMatch::CaptureNone);
+    }
+    else {
+        spectrumMatch.clear(target);
+        spectrumMatch.setCaptureTarget(target);
+    }
+
+    updateCaptureButtons();
+}
+
+void ZXOEQAudioProcessorEditor::updateCaptureButtons()
+{
+    auto target = audioProcessor.getSpectrumMatch().getCaptureTarget();
+
+    captureReferenceButton.setButtonText(target == SpectrumMatch::CaptureReference ? "Stop Reference" : "Capture Reference");
+    captureInputButton.setButtonText(target == SpectrumMatch::CaptureInput ? "Stop Input" : "Capture Input");
+}
+
+void ZXOEQAudioProcessorEditor::updateDynamicsControlsEnablement()
+{
+    auto enabled = parametricDynamicButton.getToggleState() && !parametricBypassButton.getToggleState();
+
+    parametricSidechainButton.setEnabled(enabled);
+    parametricThresholdSlider.setEnabled(enabled);
+    parametricRatioSlider.setEnabled(enabled);
+    parametricAttackSlider.setEnabled(enabled);
+    parametricReleaseSlider.setEnabled(enabled);
+}
+
+void ZXOEQAudioProcessorEditor::updateBandControlsEnablement()
+{
+    auto bypass = bandBypassButton.getToggleState();
+
+    bandTypeSelector.setEnabled(!bypass);
+    bandFrequencySlider.setEnabled(!bypass);
+    bandGainSlider.setEnabled(!bypass);
+    bandQualitySlider.setEnabled(!bypass);
+    bandChannelSelector.setEnabled(!bypass);
+
+    // only the shelves have a slope
+    auto type = bandTypeSelector.getSelectedItemIndex();
+    bandSlopeSelector.setEnabled(!bypass && (type == Band_LowShelf || type == Band_HighShelf));
+}
+
 ZXOEQAudioProcessorEditor::~ZXOEQAudioProcessorEditor()
 {
     parametricBypassButton.setLookAndFeel(nullptr);
     lowCutBypassButton.setLookAndFeel(nullptr);
     highCutBypassButton.setLookAndFeel(nullptr);
+    bandBypassButton.setLookAndFeel(nullptr);
 }
 
 
@@ -753,6 +1372,53 @@ void ZXOEQAudioProcessorEditor::resized()
 {
     auto bounds = getLocalBounds();
 
+    // Global settings along the top
+    auto settingsArea = bounds.removeFromTop(30);
+    processingModeSelector.setBounds(settingsArea.removeFromRight(125).reduced(8, 4));
+    filterEngineSelector.setBounds(settingsArea.removeFromRight(90).reduced(8, 4));
+    autoGainButton.setBounds(settingsArea.removeFromRight(100).reduced(8, 4));
+    automationRampButton.setBounds(settingsArea.removeFromRight(150).reduced(8, 4));
+
+    captureReferenceButton.setBounds(settingsArea.removeFromLeft(140).reduced(8, 4));
+    captureInputButton.setBounds(settingsArea.removeFromLeft(115).reduced(8, 4));
+    matchButton.setBounds(settingsArea.removeFromLeft(80).reduced(8, 4));
+
+    // and display settings under them
+    auto displayArea = bounds.removeFromTop(24);
+    openGLButton.setBounds(displayArea.removeFromRight(160).reduced(8, 2));
+    frameRateSelector.setBounds(displayArea.removeFromRight(110).reduced(8, 2));
+    analyzerViewSelector.setBounds(displayArea.removeFromRight(130).reduced(8, 2));
+    analyzerSourceSelector.setBounds(displayArea.removeFromRight(120).reduced(8, 2));
+    levelMeter.setBounds(displayArea.reduced(8, 2));
+
+    // Strip along the bottom for the selected extra band
+    auto bandArea = bounds.removeFromBottom(100);
+
+    // and above it the dynamics of the parametric band
+    auto dynamicsArea = bounds.removeFromBottom(100);
+
+    auto dynamicsButtonArea = dynamicsArea.removeFromLeft(140).reduced(10, 20);
+    parametricDynamicButton.setBounds(dynamicsButtonArea.removeFromTop(dynamicsButtonArea.getHeight() / 2).reduced(0, 2));
+    parametricSidechainButton.setBounds(dynamicsButtonArea.reduced(0, 2));
+
+    auto dynamicsSliderWidth = dynamicsArea.getWidth() / 4;
+    parametricThresholdSlider.setBounds(dynamicsArea.removeFromLeft(dynamicsSliderWidth));
+    parametricRatioSlider.setBounds(dynamicsArea.removeFromLeft(dynamicsSliderWidth));
+    parametricAttackSlider.setBounds(dynamicsArea.removeFromLeft(dynamicsSliderWidth));
+    parametricReleaseSlider.setBounds(dynamicsArea);
+
+    auto bandSelectorArea = bandArea.removeFromLeft(140).reduced(10, 8);
+    bandSelector.setBounds(bandSelectorArea.removeFromTop(bandSelectorArea.getHeight() / 3).reduced(0, 2));
+    bandTypeSelector.setBounds(bandSelectorArea.removeFromTop(bandSelectorArea.getHeight() / 2).reduced(0, 2));
+    bandSlopeSelector.setBounds(bandSelectorArea.reduced(0, 2));
+
+    bandBypassButton.setBounds(bandArea.removeFromRight(80).reduced(10, 25));
+    bandChannelSelector.setBounds(bandArea.removeFromRight(140).reduced(10, 36));
+
+    bandFrequencySlider.setBounds(bandArea.removeFromLeft(bandArea.getWidth() / 3));
+    bandGainSlider.setBounds(bandArea.removeFromLeft(bandArea.getWidth() / 2));
+    bandQualitySlider.setBounds(bandArea);
+
     // Half of GUI dedicated to visual response
     auto visualResponse = bounds.removeFromTop(bounds.getHeight() * 0.50);
 
@@ -769,6 +1435,9 @@ void ZXOEQAudioProcessorEditor::resized()
     lowCutBypassButton.setBounds(lowCutLocation.removeFromBottom(40));
     highCutBypassButton.setBounds(highCutLocation.removeFromBottom(40));
 
+    lowCutResponseSelector.setBounds(lowCutLocation.removeFromBottom(30).reduced(20, 3));
+    highCutResponseSelector.setBounds(highCutLocation.removeFromBottom(30).reduced(20, 3));
+
 
     lowCutFrequencySlider.setBounds(lowCutLocation.removeFromTop(lowCutLocation.getHeight() * .50));
     lowCutSlopeSlider.setBounds(lowCutLocation);
@@ -10,110 +10,33 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "SpectrumMatch.h"
 
 //==============================================================================
 /**
 */
-enum FFTOrder
-{
-    order2048 = 11,
-    order4096 = 12,
-    order8192 = 13,
-    order16384 = 14
-};
-
-template<typename BlockType>
-struct FFTDataGenerator
+template<typename PathType>
+struct AnalyzerPathGenerator
 {
-    /**
-     produces the FFT data from an audio buffer.
+    /*
+     the area the paths are drawn into, in component coordinates
      */
-    void produceFFTDataForRendering(const juce::AudioBuffer<float>& audioData, const float negativeInfinity)
+    void setBounds(juce::Rectangle<float> newBounds)
     {
-        const auto fftSize = getFFTSize();
-
-        fftData.assign(fftData.size(), 0);
-        auto* readIndex = audioData.getReadPointer(0);
-        std::copy(readIndex, readIndex + fftSize, fftData.begin());
-
-        // first apply a windowing function to our data
-        window->multiplyWithWindowingTable(fftData.data(), fftSize);       // [1]
-
-        // then render our FFT data..
-        forwardFFT->performFrequencyOnlyForwardTransform(fftData.data());  // [2]
-
-        int numBins = (int)fftSize / 2;
-
-        //normalize the fft values.
-        for (int i = 0; i < numBins; ++i)
-        {
-            auto v = fftData[i];
-            //            fftData[i] /= (float) numBins;
-            if (!std::isinf(v) && !std::isnan(v))
-            {
-                v /= float(numBins);
-            }
-            else
-            {
-                v = 0.f;
-            }
-            fftData[i] = v;
-        }
-
-        //convert them to decibels
-        for (int i = 0; i < numBins; ++i)
-        {
-            fftData[i] = juce::Decibels::gainToDecibels(fftData[i], negativeInfinity);
-        }
-
-        fftDataFifo.push(fftData);
+        fftBounds = newBounds;
     }
 
-    void changeOrder(FFTOrder newOrder)
-    {
-        //when you change order, recreate the window, forwardFFT, fifo, fftData
-        //also reset the fifoIndex
-        //things that need recreating should be created on the heap via std::make_unique<>
-
-        order = newOrder;
-        auto fftSize = getFFTSize();
-
-        forwardFFT = std::make_unique<juce::dsp::FFT>(order);
-        window = std::make_unique<juce::dsp::WindowingFunction<float>>(fftSize, juce::dsp::WindowingFunction<float>::blackmanHarris);
-
-        fftData.clear();
-        fftData.resize(fftSize * 2, 0);
-
-        fftDataFifo.prepare(fftData.size());
-    }
-    //==============================================================================
-    int getFFTSize() const { return 1 << order; }
-    int getNumAvailableFFTDataBlocks() const { return fftDataFifo.getNumAvailableForReading(); }
-    //==============================================================================
-    bool getFFTData(BlockType& fftData) { return fftDataFifo.pull(fftData); }
-private:
-    FFTOrder order;
-    BlockType fftData;
-    std::unique_ptr<juce::dsp::FFT> forwardFFT;
-    std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
-
-    Fifo<BlockType> fftDataFifo;
-};
-
-template<typename PathType>
-struct AnalyzerPathGenerator
-{
     /*
-     converts 'renderData[]' into a juce::Path
+     converts 'renderData[]' into a juce::Path, already in component coordinates so it is drawn as it is
      */
     void generatePath(const std::vector<float>& renderData,
-        juce::Rectangle<float> fftBounds,
         int fftSize,
         float binWidth,
         float negativeInfinity)
     {
+        auto left = fftBounds.getX();
         auto top = fftBounds.getY();
-        auto bottom = fftBounds.getHeight();
+        auto bottom = fftBounds.getBottom();
         auto width = fftBounds.getWidth();
 
         int numBins = (int)fftSize / 2;
@@ -125,7 +48,7 @@ struct AnalyzerPathGenerator
         {
             return juce::jmap(v,
                 negativeInfinity, 0.f,
-                float(bottom + 10), top);
+                bottom, top);
         };
 
         auto y = map(renderData[0]);
@@ -134,7 +57,7 @@ struct AnalyzerPathGenerator
         if (std::isnan(y) || std::isinf(y))
             y = bottom;
 
-        p.startNewSubPath(0, y);
+        p.startNewSubPath(left, y);
 
         const int pathResolution = 2; //you can draw line-to's every 'pathResolution' pixels.
 
@@ -149,7 +72,7 @@ struct AnalyzerPathGenerator
                 auto binFreq = binNum * binWidth;
                 auto normalizedBinX = juce::mapFromLog10(binFreq, 20.f, 20000.f);
                 int binX = std::floor(normalizedBinX * width);
-                p.lineTo(binX, y);
+                p.lineTo(left + binX, y);
             }
         }
 
@@ -167,6 +90,138 @@ struct AnalyzerPathGenerator
     }
 private:
     Fifo<PathType> pathFifo;
+    juce::Rectangle<float> fftBounds;
+};
+
+/*
+ A scrolling spectrogram. Every FFT frame becomes one column of a circular image, written
+ straight into its pixels through a colour table, so a frame costs one column and no redraw.
+ Frequency runs up the image on the analyzer's 20 Hz - 20 kHz log scale, time to the right.
+ */
+struct SpectrogramImage
+{
+    void setBounds(juce::Rectangle<int> newBounds)
+    {
+        bounds = newBounds;
+        image = juce::Image(juce::Image::PixelFormat::RGB, juce::jmax(1, bounds.getWidth()), juce::jmax(1, bounds.getHeight()), true);
+        writeColumn = 0;
+        rowBins.clear();
+    }
+
+    /*
+     the louder of the two channels for every row, 'right' may be empty
+     */
+    void addColumn(const std::vector<float>& left,
+        const std::vector<float>& right,
+        int fftSize,
+        float binWidth,
+        float negativeInfinity)
+    {
+        auto height = image.getHeight();
+        auto numBins = (int)fftSize / 2;
+
+        if ((int)rowBins.size() != height || binWidth != rowBinWidth || numBins != rowNumBins)
+            makeRowBins(height, numBins, binWidth);
+
+        if (colours.empty())
+            makeColours();
+
+        auto useRight = (int)right.size() >= numBins;
+
+        // the native image may not keep the format it was asked for, macOS hands back ARGB for RGB
+        juce::Image::BitmapData pixels(image, writeColumn, 0, 1, height, juce::Image::BitmapData::writeOnly);
+        auto isARGB = pixels.pixelFormat == juce::Image::PixelFormat::ARGB;
+        jassert(isARGB || pixels.pixelFormat == juce::Image::PixelFormat::RGB);
+
+        for (int y = 0; y < height; ++y)
+        {
+            auto level = negativeInfinity;
+
+            for (int bin = rowBins[(size_t)y].first; bin <= rowBins[(size_t)y].second; ++bin)
+            {
+                level = juce::jmax(level, left[(size_t)bin]);
+
+                if (useRight)
+                    level = juce::jmax(level, right[(size_t)bin]);
+            }
+
+            auto index = juce::jlimit(0, NumColours - 1, (int)juce::jmap(level, negativeInfinity, 0.f, 0.f, (float)(NumColours - 1)));
+
+            auto* pixel = pixels.getPixelPointer(0, y);
+
+            if (isARGB)
+                reinterpret_cast<juce::PixelARGB*>(pixel)->set(colours[(size_t)index]);
+            else
+                reinterpret_cast<juce::PixelRGB*>(pixel)->set(colours[(size_t)index]);
+        }
+
+        writeColumn = (writeColumn + 1) % image.getWidth();
+    }
+
+    /*
+     the oldest column is the next one to be written, so the image is drawn in two parts around it
+     */
+    void draw(juce::Graphics& g) const
+    {
+        auto width = image.getWidth();
+        auto height = image.getHeight();
+        auto olderWidth = width - writeColumn;
+
+        g.drawImage(image, bounds.getX(), bounds.getY(), olderWidth, height, writeColumn, 0, olderWidth, height);
+
+        if (writeColumn > 0)
+            g.drawImage(image, bounds.getX() + olderWidth, bounds.getY(), writeColumn, height, 0, 0, writeColumn, height);
+    }
+
+private:
+    static constexpr int NumColours = 256;
+
+    // the bins that fall on each pixel row, at least one per row
+    void makeRowBins(int height, int numBins, float binWidth)
+    {
+        rowBins.resize((size_t)height);
+
+        for (int y = 0; y < height; ++y)
+        {
+            auto lowFrequency = juce::mapToLog10(1.f - float(y + 1) / float(height), 20.f, 20000.f);
+            auto highFrequency = juce::mapToLog10(1.f - float(y) / float(height), 20.f, 20000.f);
+
+            auto first = juce::jlimit(1, numBins - 1, (int)(lowFrequency / binWidth));
+            auto last = juce::jlimit(first, numBins - 1, (int)(highFrequency / binWidth));
+
+            rowBins[(size_t)y] = { first, last };
+        }
+
+        rowBinWidth = binWidth;
+        rowNumBins = numBins;
+    }
+
+    void makeColours()
+    {
+        juce::ColourGradient gradient;
+        gradient.addColour(0.0, juce::Colours::black);
+        gradient.addColour(0.3, juce::Colours::navy);
+        gradient.addColour(0.5, juce::Colours::purple);
+        gradient.addColour(0.7, juce::Colours::red);
+        gradient.addColour(0.85, juce::Colours::orange);
+        gradient.addColour(0.95, juce::Colours::yellow);
+        gradient.addColour(1.0, juce::Colours::white);
+
+        colours.resize(NumColours);
+
+        for (int i = 0; i < NumColours; ++i)
+            colours[(size_t)i] = gradient.getColourAtPosition(double(i) / double(NumColours - 1)).getPixelARGB();
+    }
+
+    juce::Rectangle<int> bounds;
+    juce::Image image;
+    int writeColumn = 0;
+
+    std::vector<std::pair<int, int>> rowBins;
+    float rowBinWidth = 0.f;
+    int rowNumBins = 0;
+
+    std::vector<juce::PixelARGB> colours;
 };
 
 struct LookAndFeel : juce::LookAndFeel_V4 {
@@ -196,6 +251,11 @@ struct RotarySliderWithLabels : juce::Slider {
 
     juce::Array<LabelPositions> labels;
 
+    void setAudioParameter(juce::RangedAudioParameter& value) {
+        audioParam = &value;
+        repaint();
+    }
+
     void paint(juce::Graphics& g) override;
     juce::Rectangle<int> getSliderBounds() const;
     int getTextHeight() const { return 14; }
@@ -211,7 +271,7 @@ private:
 
 };
 
-struct ResponseCurveComponent : juce::Component, juce::AudioProcessorParameter::Listener, juce::Timer {
+struct ResponseCurveComponent : juce::Component, juce::AudioProcessorParameter::Listener, juce::OpenGLRenderer {
    
     ResponseCurveComponent(ZXOEQAudioProcessor&);
    
@@ -221,7 +281,11 @@ struct ResponseCurveComponent : juce::Component, juce::AudioProcessorParameter::
 
     void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override { }
 
-    void timerCallback() override;
+    // Called on every vertical blank, runs a frame only as often as getFrameRate() allows
+    void vBlankCallback();
+
+    // Drains the analyzer FIFOs and repaints what changed, returns whether anything did
+    bool updateFrame();
 
     void paint(juce::Graphics& g) override;
     
@@ -229,22 +293,70 @@ struct ResponseCurveComponent : juce::Component, juce::AudioProcessorParameter::
 
     void resized() override;
 
+    // Opt-in GPU rendering, the component paints the same either way and JUCE's GL renderer rasterises it
+    void newOpenGLContextCreated() override;
+    void renderOpenGL() override;
+    void openGLContextClosing() override { }
+
 
 
 private:
     ZXOEQAudioProcessor& audioProcessor;
     juce::Atomic<bool> shouldUpdateParameters{ false };
 
-    MonoChain MonoChain;
+    juce::OpenGLContext openGLContext;
+    bool openGLUnavailable = false;
+
+    void updateRenderer();
+
+    // one curve per channel, the second one is only drawn when the channels differ
+    std::array<std::vector<SectionCoefficients>, SectionCascade::MaxChannels> responseSections;
+    bool channelsAreLinked = true;
 
+    // The grid and the response curves are cached layers, redrawn on resize and on parameter changes.
+    // They hold layerScale pixels per point, so they stay sharp on high density displays.
     juce::Image background;
+    juce::Image curveLayer;
+    float layerScale = 1.f;
+
+    juce::Image makeLayer(juce::Image::PixelFormat format) const;
+    void drawLayer(juce::Graphics& g, const juce::Image& layer) const;
+
+    void renderResponseCurves();
 
     juce::Rectangle<int> getAnalysisArea();
 
     juce::Rectangle<int> getRenderArea();
 
+    // Frames follow the display up to the user's cap, slower while nothing moves or nobody can see them
+    static constexpr double StaticFrameRate = 30.0;
+    static constexpr double HiddenFrameRate = 15.0;
+    static constexpr int FramesUntilStatic = 30;
+
+    double getFrameRate();
+
+    double lastFrameTime = 0.0;
+    int framesWithoutChange = 0;
+
+    static constexpr double PerformanceUpdateInterval = 250.0;
+    double lastPerformanceUpdate = 0.0;
+    juce::String performanceText;
+
+    juce::String makePerformanceText();
+    juce::Rectangle<int> getPerformanceArea();
+
+    // the output loudness, refreshed along with the counters in the other corner
+    juce::String loudnessText;
+
+    juce::String makeLoudnessText();
+    juce::Rectangle<int> getLoudnessArea();
+
+    juce::VBlankAttachment vBlankAttachment;
+
     SingleChannelSampleFifo<ZXOEQAudioProcessor::BlockType>* leftChannelFifo;
     SingleChannelSampleFifo<ZXOEQAudioProcessor::BlockType>* rightChannelFifo;
+    SingleChannelSampleFifo<ZXOEQAudioProcessor::BlockType>* inputLeftChannelFifo;
+    SingleChannelSampleFifo<ZXOEQAudioProcessor::BlockType>* inputRightChannelFifo;
 
 
     juce::AudioBuffer<float> monoBufferL;
@@ -253,6 +365,31 @@ private:
     FFTDataGenerator<std::vector<float>> leftChannelFFTDataGenerator;
     FFTDataGenerator<std::vector<float>> rightChannelFFTDataGenerator;
 
+    // The input tap, analysed only when the input or the difference is shown
+    juce::AudioBuffer<float> inputMonoBufferL;
+    juce::AudioBuffer<float> inputMonoBufferR;
+
+    FFTDataGenerator<std::vector<float>> inputLeftChannelFFTDataGenerator;
+    FFTDataGenerator<std::vector<float>> inputRightChannelFFTDataGenerator;
+
+    std::vector<float> inputFFTData;
+
+    // The difference is drawn on the response curve's scale, 0 dB in the middle
+    static constexpr float DifferenceRange = 30.f;
+    int analyzerSource = Source_Output;
+    int inputTapRestartsSeen = 0;
+
+    void pullAnalyzerTap(SingleChannelSampleFifo<ZXOEQAudioProcessor::BlockType>& fifo,
+        juce::AudioBuffer<float>& monoBuffer,
+        FFTDataGenerator<std::vector<float>>& generator,
+        bool analyze);
+
+    bool pullAnalyzerFrame(FFTDataGenerator<std::vector<float>>& output,
+        FFTDataGenerator<std::vector<float>>& input,
+        std::vector<float>& frame);
+
+    void discardFFTData(FFTDataGenerator<std::vector<float>>& generator);
+
 
     AnalyzerPathGenerator<juce::Path> pathProducerL;
     AnalyzerPathGenerator<juce::Path> pathProducerR;
@@ -260,6 +397,51 @@ private:
     juce::Path LeftChannelFFTPath;
     juce::Path RightChannelFFTPath;
 
+    // Spectrogram view, fed by the same FFT frames in place of the paths
+    SpectrogramImage spectrogram;
+    std::vector<float> latestFFTDataR;
+    bool showSpectrogram = false;
+
+};
+
+// Input and output levels as bars, the RMS filled and the peak as a line, with the output's held true peak.
+// The true peak is only measured while this is on screen, a click resets its hold and the integrated loudness.
+struct LevelMeterComponent : juce::Component {
+
+    LevelMeterComponent(ZXOEQAudioProcessor&);
+
+    ~LevelMeterComponent();
+
+    void paint(juce::Graphics& g) override;
+
+    void mouseDown(const juce::MouseEvent& event) override;
+
+private:
+    ZXOEQAudioProcessor& audioProcessor;
+
+    static constexpr float MinimumDecibels = -60.f;
+    static constexpr float MaximumDecibels = 6.f;
+    static constexpr float PeakDecayPerSecond = 20.f;
+    static constexpr double FrameRate = 30.0;
+
+    // the louder channel, in decibels
+    struct Levels {
+        float peak = MinimumDecibels;
+        float rms = MinimumDecibels;
+
+        bool operator!=(const Levels& other) const { return peak != other.peak || rms != other.rms; }
+    };
+
+    Levels input;
+    Levels output;
+    float truePeakHold = MinimumDecibels;
+
+    void vBlankCallback();
+    void update(Levels& levels, const LevelMeter::Reading& reading, double elapsedSeconds);
+    void drawBar(juce::Graphics& g, juce::Rectangle<float> area, const juce::String& label, const Levels& levels);
+
+    double lastFrameTime = 0.0;
+    juce::VBlankAttachment vBlankAttachment;
 };
 
 class ZXOEQAudioProcessorEditor  : public juce::AudioProcessorEditor
@@ -303,6 +485,12 @@ private:
     juce::AudioProcessorValueTreeState::SliderAttachment lowCutSlopeSliderAttachment;
     juce::AudioProcessorValueTreeState::SliderAttachment highCutSlopeSliderAttachment;
 
+    juce::ComboBox lowCutResponseSelector;
+    juce::ComboBox highCutResponseSelector;
+
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> lowCutResponseSelectorAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> highCutResponseSelectorAttachment;
+
     juce::ToggleButton lowCutBypassButton;
     juce::ToggleButton highCutBypassButton;
     juce::ToggleButton parametricBypassButton;
@@ -313,6 +501,82 @@ private:
     juce::AudioProcessorValueTreeState::ButtonAttachment parametricBypassButtonAttachment;
     juce::AudioProcessorValueTreeState::ButtonAttachment analyzerEnableButtonAttachment;
 
+    juce::ComboBox processingModeSelector;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> processingModeSelectorAttachment;
+
+    juce::ComboBox filterEngineSelector;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> filterEngineSelectorAttachment;
+
+    juce::ToggleButton autoGainButton{ "Auto Gain" };
+    juce::AudioProcessorValueTreeState::ButtonAttachment autoGainButtonAttachment;
+
+    juce::ToggleButton automationRampButton{ "Ramp Automation" };
+    juce::AudioProcessorValueTreeState::ButtonAttachment automationRampButtonAttachment;
+
+    juce::ComboBox analyzerSourceSelector;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> analyzerSourceSelectorAttachment;
+
+    juce::ComboBox analyzerViewSelector;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> analyzerViewSelectorAttachment;
+
+    juce::ComboBox frameRateSelector;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> frameRateSelectorAttachment;
+
+    LevelMeterComponent levelMeter;
+
+    juce::ToggleButton openGLButton{ "OpenGL Rendering" };
+    juce::AudioProcessorValueTreeState::ButtonAttachment openGLButtonAttachment;
+
+    // Spectrum match, each capture button starts and stops its own capture
+    juce::TextButton captureReferenceButton{ "Capture Reference" };
+    juce::TextButton captureInputButton{ "Capture Input" };
+    juce::TextButton matchButton{ "Match" };
+
+    void toggleCapture(SpectrumMatch::CaptureTarget target);
+    void updateCaptureButtons();
+
+    // Dynamics of the parametric band
+    juce::ToggleButton parametricDynamicButton{ "Dynamic" };
+    juce::ToggleButton parametricSidechainButton{ "Sidechain" };
+
+    RotarySliderWithLabels parametricThresholdSlider;
+    RotarySliderWithLabels parametricRatioSlider;
+    RotarySliderWithLabels parametricAttackSlider;
+    RotarySliderWithLabels parametricReleaseSlider;
+
+    juce::AudioProcessorValueTreeState::ButtonAttachment parametricDynamicButtonAttachment;
+    juce::AudioProcessorValueTreeState::ButtonAttachment parametricSidechainButtonAttachment;
+
+    juce::AudioProcessorValueTreeState::SliderAttachment parametricThresholdSliderAttachment;
+    juce::AudioProcessorValueTreeState::SliderAttachment parametricRatioSliderAttachment;
+    juce::AudioProcessorValueTreeState::SliderAttachment parametricAttackSliderAttachment;
+    juce::AudioProcessorValueTreeState::SliderAttachment parametricReleaseSliderAttachment;
+
+    void updateDynamicsControlsEnablement();
+
+    // One strip edits whichever extra band is selected, its attachments are swapped on selection
+    juce::ComboBox bandSelector;
+    juce::ComboBox bandTypeSelector;
+    juce::ComboBox bandSlopeSelector;
+    juce::ComboBox bandChannelSelector;
+
+    RotarySliderWithLabels bandFrequencySlider;
+    RotarySliderWithLabels bandGainSlider;
+    RotarySliderWithLabels bandQualitySlider;
+
+    juce::ToggleButton bandBypassButton;
+
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> bandTypeSelectorAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> bandSlopeSelectorAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> bandChannelSelectorAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> bandFrequencySliderAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> bandGainSliderAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> bandQualitySliderAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> bandBypassButtonAttachment;
+
+    void showBand(int bandIndex);
+    void updateBandControlsEnablement();
+
     LookAndFeel LookNF;
 
 
@@ -8,6 +8,7 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "SpectrumMatch.h"
 
 //==============================================================================
 ZXOEQAudioProcessor::ZXOEQAudioProcessor()
@@ -16,12 +17,19 @@ ZXOEQAudioProcessor::ZXOEQAudioProcessor()
                      #if ! JucePlugin_IsMidiEffect
                       #if ! JucePlugin_IsSynth
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                       .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
                        )
 #endif
 {
+    static std::atomic<int> numInstancesCreated{ 0 };
+    instanceNumber = ++numInstancesCreated;
+
+    traceRecorder.setEnabled(getDiagnosticsDirectory("ZXOEQ_TRACE_DIR") != juce::File());
+
+    spectrumMatch = std::make_unique<SpectrumMatch>();
 }
 
 ZXOEQAudioProcessor::~ZXOEQAudioProcessor()
@@ -63,7 +71,7 @@ bool ZXOEQAudioProcessor::isMidiEffect() const
 
 double ZXOEQAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    return tailLengthSeconds.load();
 }
 
 int ZXOEQAudioProcessor::getNumPrograms()
@@ -96,737 +104,826 @@ void ZXOEQAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
 
-    juce::dsp::ProcessSpec spec;
+    performanceCounters.prepare(sampleRate);
 
-    spec.maximumBlockSize = samplesPerBlock;
+    cascade.reset();
+    svfCascade.reset();
+    dynamicSection.prepare(sampleRate);
 
-    spec.numChannels = 1;
-    spec.sampleRate = sampleRate;
+    estimateIntervalSamples = (juce::int64)(EstimateIntervalSeconds * sampleRate);
 
-    left.prepare(spec);
-    right.prepare(spec);
+    auto chainParameters = getChainParameters(chainParameterPointers);
+    updateCoefficients(chainParameters);
+    updateEstimates(chainParameters);
 
+    // the first change is estimated straight away
+    samplesSinceEstimates = estimateIntervalSamples;
 
-    auto chainParameters = getChainParameters(state);
+    silentSamples = 0;
+    isResting = false;
 
-    auto parametricCoeffs = juce::dsp::IIR::Coefficients<float>::makePeakFilter(
-        sampleRate, 
-        chainParameters.parametricFrequency, 
-        chainParameters.parametricQuality,
-        juce::Decibels::decibelsToGain(chainParameters.parametricGain));
+    autoGain.reset(sampleRate, 0.1);
+    autoGain.setCurrentAndTargetValue(autoGain.getTargetValue());
 
+    leftChannelFifo.prepare(samplesPerBlock);
+    rightChannelFifo.prepare(samplesPerBlock);
+    inputLeftChannelFifo.prepare(samplesPerBlock);
+    inputRightChannelFifo.prepare(samplesPerBlock);
+    inputTapWasActive = false;
 
+    inputMeter.prepare(sampleRate, samplesPerBlock, false);
+    outputMeter.prepare(sampleRate, samplesPerBlock, true);
+    loudnessMeter.prepare(sampleRate, samplesPerBlock);
 
+    spectrumMatch->prepare(sampleRate);
+}
 
+void ZXOEQAudioProcessor::releaseResources()
+{
+    // When playback stops, you can use this as an opportunity to free up any
+    // spare memory, etc.
 
-    *left.get<ChainLocations::Parametric>().coefficients = *parametricCoeffs;
-    *right.get<ChainLocations::Parametric>().coefficients = *parametricCoeffs;
+    dumpPerformanceCounters();
+    dumpTrace();
+}
 
-    left.setBypassed<ChainLocations::Parametric>(chainParameters.parametricBypass);
-    right.setBypassed<ChainLocations::Parametric>(chainParameters.parametricBypass);
+// Returns the directory named by the given environment variable, or an empty File if it isn't set
+juce::File getDiagnosticsDirectory(const char* environmentVariable)
+{
+    auto directoryName = juce::SystemStats::getEnvironmentVariable(environmentVariable, {});
 
-    // Slope Choice for low cut coefficients
-    // Slope choice of 0 corresponds to 12 dB per octave translating to an order of 2
-    // Slope choice of 1 corresponds to 24 dB per octave translating to an order of 4, etc...
-    
-    auto lowCutCoefficients = juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(chainParameters.lowCutFrequency, 
-        sampleRate, 
-        (2 * (chainParameters.lowCutSlope + 1)));
+    if (directoryName.isEmpty() || !juce::File::isAbsolutePath(directoryName))
+        return {};
 
-    // Left audio chain initialization -> lowCut filter chain
-    
-    auto& leftLowCut = left.get<ChainLocations::LowCut>();
- 
-    
+    juce::File directory(directoryName);
 
-    // bypass positions in chain
+    if (!directory.isDirectory() && !directory.createDirectory())
+        return {};
 
-    leftLowCut.setBypassed<0>(true);
-    leftLowCut.setBypassed<1>(true);
-    leftLowCut.setBypassed<2>(true);
-    leftLowCut.setBypassed<3>(true);
+    return directory;
+}
 
+// Headless instances have no overlay to look at, so when ZXOEQ_STATS_DIR is set
+// the counters are written to a text file there every time playback stops.
+void ZXOEQAudioProcessor::dumpPerformanceCounters()
+{
+    auto directory = getDiagnosticsDirectory("ZXOEQ_STATS_DIR");
 
-    left.setBypassed<ChainLocations::LowCut>(chainParameters.lowCutBypass);
+    if (directory == juce::File())
+        return;
 
-    switch (chainParameters.lowCutSlope) {
+    juce::String text;
+    text << "instance: " << instanceNumber << "\n";
+    text << performanceCounters.toString();
 
-    case Slope_12dB:
-    {
-        *leftLowCut.get<0>().coefficients = *lowCutCoefficients[0];
-        leftLowCut.setBypassed<0>(false);
-        break;
-    }
+    directory.getChildFile("ZXOEQ-stats-" + juce::String(instanceNumber) + ".txt").replaceWithText(text);
+}
 
-    case Slope_24dB:
-    {
-        *leftLowCut.get<0>().coefficients = *lowCutCoefficients[0];
-        leftLowCut.setBypassed<0>(false);
-        *leftLowCut.get<1>().coefficients = *lowCutCoefficients[1];
-        leftLowCut.setBypassed<1>(false);
-        break;
-    }
+// Tracing is switched on for the lifetime of the instance by ZXOEQ_TRACE_DIR, the spans
+// recorded since the last stop are written out as a Chrome trace (chrome://tracing, ui.perfetto.dev)
+void ZXOEQAudioProcessor::dumpTrace()
+{
+    if (!traceRecorder.isEnabled())
+        return;
 
+    auto directory = getDiagnosticsDirectory("ZXOEQ_TRACE_DIR");
 
+    if (directory == juce::File())
+        return;
 
-    case Slope_36dB: {
+    auto file = directory.getNonexistentChildFile("ZXOEQ-trace-" + juce::String(instanceNumber), ".json");
+    traceRecorder.writeChromeTrace(file, instanceNumber);
+}
 
-        *leftLowCut.get<0>().coefficients = *lowCutCoefficients[0];
-        leftLowCut.setBypassed<0>(false);
-        *leftLowCut.get<1>().coefficients = *lowCutCoefficients[1];
-        leftLowCut.setBypassed<1>(false);
-        *leftLowCut.get<2>().coefficients = *lowCutCoefficients[2];
-        leftLowCut.setBypassed<2>(false);
-        break;
-    }
+#ifndef JucePlugin_PreferredChannelConfigurations
+bool ZXOEQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
+{
+  #if JucePlugin_IsMidiEffect
+    juce::ignoreUnused (layouts);
+    return true;
+  #else
+    // This is the place where you check if the layout is supported.
+    // In this template code we only support mono or stereo.
+    // Some plugin hosts, such as certain GarageBand versions, will only
+    // load plugins that support stereo bus layouts.
+    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
+     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+        return false;
 
+    // This checks if the input layout matches the output layout
+   #if ! JucePlugin_IsSynth
+    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
+        return false;
 
-    case Slope_48dB: {
-        *leftLowCut.get<0>().coefficients = *lowCutCoefficients[0];
-        leftLowCut.setBypassed<0>(false);
-        *leftLowCut.get<1>().coefficients = *lowCutCoefficients[1];
-        leftLowCut.setBypassed<1>(false);
-        *leftLowCut.get<2>().coefficients = *lowCutCoefficients[2];
-        leftLowCut.setBypassed<2>(false);
-        *leftLowCut.get<3>().coefficients = *lowCutCoefficients[3];
-        leftLowCut.setBypassed<3>(false);
-        break;
-    
-    }
+    // The sidechain can be left off, otherwise it is mono or stereo like the main bus
+    if (layouts.inputBuses.size() > 1) {
+
+        auto sidechain = layouts.getChannelSet(true, 1);
+
+        if (!sidechain.isDisabled()
+         && sidechain != juce::AudioChannelSet::mono()
+         && sidechain != juce::AudioChannelSet::stereo())
+            return false;
     }
+   #endif
 
-    auto& rightLowCut = right.get<ChainLocations::LowCut>();
+    return true;
+  #endif
+}
+#endif
 
+// Only called when the parameters actually changed, so the cascade is left alone while nothing moves.
+// The estimates cost far more than the coefficients. While the parameters keep moving they are redone
+// at most once per EstimateIntervalSeconds, a change that had to wait is caught up at the end of a block.
+void ZXOEQAudioProcessor::updateFilters(const ChainParameters& chainParameters) {
 
+    updateCoefficients(chainParameters);
 
-    // bypass positions in chain
+    estimatesPending = true;
 
-    rightLowCut.setBypassed<0>(true);
-    rightLowCut.setBypassed<1>(true);
-    rightLowCut.setBypassed<2>(true);
-    rightLowCut.setBypassed<3>(true);
-    
+    if (samplesSinceEstimates >= estimateIntervalSamples)
+        updateEstimates(chainParameters);
+}
 
-    right.setBypassed<ChainLocations::LowCut>(chainParameters.lowCutBypass);
+void ZXOEQAudioProcessor::updateEstimates(const ChainParameters& chainParameters) {
 
-    switch (chainParameters.lowCutSlope) {
+    ScopedTraceSpan estimateSpan(traceRecorder, TraceRecorder::AudioThread, "auto gain and tail estimate");
 
-    case Slope_12dB:
-    {
-        *rightLowCut.get<0>().coefficients = *lowCutCoefficients[0];
-        rightLowCut.setBypassed<0>(false);
-        break;
-    }
+    autoGain.setTargetValue(getAutoGainTarget(chainParameters));
 
-    case Slope_24dB:
-    {
-        *rightLowCut.get<0>().coefficients = *lowCutCoefficients[0];
-        rightLowCut.setBypassed<0>(false);
-        *rightLowCut.get<1>().coefficients = *lowCutCoefficients[1];
-        rightLowCut.setBypassed<1>(false);
-        break;
-    }
+    // the dynamic band is counted at its resting gain
+    makeChainSections(chainParameters, tailSections);
 
+    tailSamples = (juce::int64)std::ceil(getDecaySamples(tailSections, getSampleRate(), TailDecayDecibels));
+    tailLengthSeconds.store(getSampleRate() > 0.0 ? (double)tailSamples / getSampleRate() : 0.0);
 
+    estimatesPending = false;
+    samplesSinceEstimates = 0;
+}
 
-    case Slope_36dB: {
+void ZXOEQAudioProcessor::updateCoefficients(const ChainParameters& chainParameters) {
 
-        *rightLowCut.get<0>().coefficients = *lowCutCoefficients[0];
-        rightLowCut.setBypassed<0>(false);
-        *rightLowCut.get<1>().coefficients = *lowCutCoefficients[1];
-        rightLowCut.setBypassed<1>(false);
-        *rightLowCut.get<2>().coefficients = *lowCutCoefficients[2];
-        rightLowCut.setBypassed<2>(false);
-        break;
-    }
+    ScopedTraceSpan designSpan(traceRecorder, TraceRecorder::AudioThread, "coefficient design");
 
+    makeChainSections(chainParameters, sections, false);
 
-    case Slope_48dB: {
-        *rightLowCut.get<0>().coefficients = *lowCutCoefficients[0];
-        rightLowCut.setBypassed<0>(false);
-        *rightLowCut.get<1>().coefficients = *lowCutCoefficients[1];
-        rightLowCut.setBypassed<1>(false);
-        *rightLowCut.get<2>().coefficients = *lowCutCoefficients[2];
-        rightLowCut.setBypassed<2>(false);
-        *rightLowCut.get<3>().coefficients = *lowCutCoefficients[3];
-        rightLowCut.setBypassed<3>(false);
-        break;
+    // the engine that takes over starts from silence rather than from whatever it held when it was left
+    auto engineChanged = chainParameters.filterEngine != currentChainParameters.filterEngine;
 
-    }
-    }
+    if (chainParameters.filterEngine == Engine_StateVariable) {
 
-    // FOR HIGH CUT ( LOW PASS HIGH ORDER)
-    auto highCutCoefficients = juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(chainParameters.highCutFrequency,
-        sampleRate,
-        (2 * (chainParameters.highCutSlope + 1)));
+        if (engineChanged)
+            svfCascade.reset();
 
-    auto& leftHighCut = left.get<ChainLocations::HighCut>();
+        svfCascade.setSections(sections, getSampleRate(), !engineChanged);
+    }
+    else {
 
-   
-  
-    
-    leftHighCut.setBypassed<0>(true);
-    leftHighCut.setBypassed<1>(true);
-    leftHighCut.setBypassed<2>(true);
-    leftHighCut.setBypassed<3>(true);
+        if (engineChanged)
+            cascade.reset();
+
+        cascade.setSections(sections, getSampleRate());
+    }
 
-    left.setBypassed<ChainLocations::HighCut>(chainParameters.highCutBypass);
+    if (hasDynamicParametric(chainParameters)) {
 
+        DynamicSection::Parameters dynamicParameters;
+        dynamicParameters.frequency = chainParameters.parametricFrequency;
+        dynamicParameters.quality = chainParameters.parametricQuality;
+        dynamicParameters.gain = chainParameters.parametricGain;
+        dynamicParameters.threshold = chainParameters.parametricThreshold;
+        dynamicParameters.ratio = chainParameters.parametricRatio;
+        dynamicParameters.attack = chainParameters.parametricAttack;
+        dynamicParameters.release = chainParameters.parametricRelease;
 
-    switch (chainParameters.highCutSlope) {
+        dynamicSection.setParameters(dynamicParameters);
 
-    case Slope_12dB:
-    {
-        *leftHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        leftHighCut.setBypassed<0>(false);
-        break;
+        // coming out of the cascade, start from the resting gain
+        if (!hasDynamicParametric(currentChainParameters))
+            dynamicSection.reset();
     }
 
-    case Slope_24dB:
-    {
-        *leftHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        leftHighCut.setBypassed<0>(false);
-        *leftHighCut.get<1>().coefficients = *highCutCoefficients[1];
-        leftHighCut.setBypassed<1>(false);
-        break;
-    }
+    currentChainParameters = chainParameters;
 
+    performanceCounters.coefficientsRedesigned();
+}
 
+// The dynamic band counts at its resting gain, so the estimate doesn't move while it works.
+// Outside of stereo mode both channels are averaged, which keeps one gain for every mode.
+float ZXOEQAudioProcessor::getAutoGainTarget(const ChainParameters& chainParameters) {
 
-    case Slope_36dB: {
+    if (!chainParameters.autoGain)
+        return 1.f;
 
-        *leftHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        leftHighCut.setBypassed<0>(false);
-        *leftHighCut.get<1>().coefficients = *highCutCoefficients[1];
-        leftHighCut.setBypassed<1>(false);
-        *leftHighCut.get<2>().coefficients = *highCutCoefficients[2];
-        leftHighCut.setBypassed<2>(false);
-        break;
-    }
+    makeChainSections(chainParameters, loudnessSections);
 
+    auto power = getWeightedPowerGain(loudnessSections, 0, getSampleRate());
 
-    case Slope_48dB: {
-        *leftHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        leftHighCut.setBypassed<0>(false);
-        *leftHighCut.get<1>().coefficients = *highCutCoefficients[1];
-        leftHighCut.setBypassed<1>(false);
-        *leftHighCut.get<2>().coefficients = *highCutCoefficients[2];
-        leftHighCut.setBypassed<2>(false);
-        *leftHighCut.get<3>().coefficients = *highCutCoefficients[3];
-        leftHighCut.setBypassed<3>(false);
-        break;
+    if (chainParameters.processingMode != Mode_Stereo)
+        power = 0.5 * (power + getWeightedPowerGain(loudnessSections, 1, getSampleRate()));
 
-    }
-    }
+    auto compensation = juce::Decibels::gainToDecibels(1.0 / std::sqrt(juce::jmax(power, 1.0e-12)));
 
-    auto& rightHighCut = right.get<ChainLocations::HighCut>();
+    return juce::Decibels::decibelsToGain((float)juce::jlimit(-24.0, 24.0, compensation));
+}
 
-   
+bool ZXOEQAudioProcessor::hasDynamicParametric(const ChainParameters& chainParameters) const {
 
-    rightHighCut.setBypassed<0>(true);
-    rightHighCut.setBypassed<1>(true);
-    rightHighCut.setBypassed<2>(true);
-    rightHighCut.setBypassed<3>(true);
+    return chainParameters.parametricDynamic && !chainParameters.parametricBypass;
+}
 
-    right.setBypassed<ChainLocations::HighCut>(chainParameters.highCutBypass);
+void makeChainSections(const ChainParameters& chainParameters, SectionList& sections, bool includeDynamicBands) {
 
+    sections.clear();
 
-    switch (chainParameters.highCutSlope) {
+    // Slope choice of 0 corresponds to 12 dB per octave translating to an order of 2
+    // Slope choice of 1 corresponds to 24 dB per octave translating to an order of 4, etc...
 
-    case Slope_12dB:
-    {
-        *rightHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        rightHighCut.setBypassed<0>(false);
-        break;
+    // Every filter keeps its slot whether the ones before it are on or not, so the cascades can carry its state over
+    enum { LowCutSlot, ParametricSlot, FirstBandSlot, HighCutSlot = FirstBandSlot + MaxBands };
+
+    if (!chainParameters.lowCutBypass) {
+        addCutSections(sections, chainParameters.lowCutFrequency, 2 * (chainParameters.lowCutSlope + 1), chainParameters.lowCutResponse, true);
+        sections.setSlot(0, LowCutSlot);
     }
 
-    case Slope_24dB:
-    {
-        *rightHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        rightHighCut.setBypassed<0>(false);
-        *rightHighCut.get<1>().coefficients = *highCutCoefficients[1];
-        rightHighCut.setBypassed<1>(false);
-        break;
+    if (!chainParameters.parametricBypass && (includeDynamicBands || !chainParameters.parametricDynamic)) {
+        sections.add(makePeakSection(chainParameters.parametricFrequency, chainParameters.parametricQuality,
+            juce::Decibels::decibelsToGain(chainParameters.parametricGain)));
+        sections.setSlot(sections.size - 1, ParametricSlot);
     }
 
+    for (int bandIndex = 0; bandIndex < MaxBands; ++bandIndex) {
 
+        const auto& band = chainParameters.bands[(size_t)bandIndex];
 
-    case Slope_36dB: {
+        if (band.bypass)
+            continue;
 
-        *rightHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        rightHighCut.setBypassed<0>(false);
-        *rightHighCut.get<1>().coefficients = *highCutCoefficients[1];
-        rightHighCut.setBypassed<1>(false);
-        *rightHighCut.get<2>().coefficients = *highCutCoefficients[2];
-        rightHighCut.setBypassed<2>(false);
-        break;
-    }
+        auto firstSection = sections.size;
 
+        switch (band.type) {
 
-    case Slope_48dB: {
-        *rightHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        rightHighCut.setBypassed<0>(false);
-        *rightHighCut.get<1>().coefficients = *highCutCoefficients[1];
-        rightHighCut.setBypassed<1>(false);
-        *rightHighCut.get<2>().coefficients = *highCutCoefficients[2];
-        rightHighCut.setBypassed<2>(false);
-        *rightHighCut.get<3>().coefficients = *highCutCoefficients[3];
-        rightHighCut.setBypassed<3>(false);
-        break;
+        case Band_Peak:
+            sections.add(makePeakSection(band.frequency, band.quality, juce::Decibels::decibelsToGain(band.gain)));
+            break;
 
-    }
-    }
+        case Band_Notch:
+            sections.add(makeNotchSection(band.frequency, band.quality));
+            break;
 
-    leftChannelFifo.prepare(samplesPerBlock);
-    rightChannelFifo.prepare(samplesPerBlock);
+        case Band_BandPass:
+            sections.add(makeBandPassSection(band.frequency, band.quality));
+            break;
 
+        case Band_Tilt:
+            sections.add(makeTiltSection(band.frequency, band.quality, juce::Decibels::decibelsToGain(band.gain)));
+            break;
 
+        // Shelves take their order from the band slope the same way the cuts do
+        case Band_LowShelf:
+        case Band_HighShelf:
+            addShelfSections(sections, band.frequency, band.quality, juce::Decibels::decibelsToGain(band.gain), 2 * (band.slope + 1), band.type == Band_HighShelf);
+            break;
+        }
 
-}
+        sections.setSlot(firstSection, FirstBandSlot + bandIndex);
 
-void ZXOEQAudioProcessor::releaseResources()
-{
-    // When playback stops, you can use this as an opportunity to free up any
-    // spare memory, etc.
+        // Stereo mode links both channels, so the band's channel only counts in the other modes
+        if (chainParameters.processingMode != Mode_Stereo && band.channel != BandChannel_Both) {
+            sections.setChannel(firstSection, band.channel == BandChannel_First ? 0 : 1);
+        }
+    }
+
+    if (!chainParameters.highCutBypass) {
+        auto firstSection = sections.size;
+        addCutSections(sections, chainParameters.highCutFrequency, 2 * (chainParameters.highCutSlope + 1), chainParameters.highCutResponse, false);
+        sections.setSlot(firstSection, HighCutSlot);
+    }
 }
 
-#ifndef JucePlugin_PreferredChannelConfigurations
-bool ZXOEQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
-{
-  #if JucePlugin_IsMidiEffect
-    juce::ignoreUnused (layouts);
-    return true;
-  #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
-        return false;
 
-    // This checks if the input layout matches the output layout
-   #if ! JucePlugin_IsSynth
-    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
-        return false;
-   #endif
+void ZXOEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ScopedNoDenormals noDenormals;
+    PerformanceCounters::ScopedBlockTimer blockTimer(performanceCounters, buffer.getNumSamples());
+    ScopedTraceSpan blockSpan(traceRecorder, TraceRecorder::AudioThread, "processBlock");
 
-    return true;
-  #endif
-}
-#endif
+    auto totalNumInputChannels  = getTotalNumInputChannels();
+    auto totalNumOutputChannels = getTotalNumOutputChannels();
 
-// FOR RESPONSE CURVE SINCE I DON'T KNOW HOW ELSE <------------------->
+    // In case we have more outputs than inputs, this code clears any output
+    // channels that didn't contain input data, (because these aren't
+    // guaranteed to be empty - they may contain garbage).
+    // This is here to avoid people getting screaming feedback
+    // when they first compile a plugin, but obviously you don't need to keep
+    // this code if your algorithm always overwrites all the output channels.
+    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
+        buffer.clear (i, 0, buffer.getNumSamples());
 
-Coefficients makeParametricFilter(const ChainParameters& chainParameters, double sampleRate) {
     
-    return juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate, chainParameters.parametricFrequency,
-        chainParameters.parametricQuality, juce::Decibels::decibelsToGain(chainParameters.parametricGain));
-}
 
+    // the match compares what comes in, before any of our filtering
+    spectrumMatch->pushSamples(buffer, getMainBusNumInputChannels());
 
-void ZXOEQAudioProcessor::updateParametricFilter(const ChainParameters & chainParameters) {
+    auto tapActive = inputTapActive.load();
 
+    // both taps cut their buffers from the same sample on, or difference frames pair different moments
+    if (tapActive && !inputTapWasActive) {
 
-    auto parametricCoefficients = makeParametricFilter(chainParameters, getSampleRate());
+        for (auto* fifo : { &leftChannelFifo, &rightChannelFifo, &inputLeftChannelFifo, &inputRightChannelFifo })
+            fifo->restart();
 
+        ++inputTapRestarts;
+    }
 
-    //left.setBypassed<ChainLocations::Parametric>(chainParameters.parametricBypass);
-    //right.setBypassed<ChainLocations::Parametric>(chainParameters.parametricBypass);
+    inputTapWasActive = tapActive;
 
+    if (tapActive) {
 
-    updateCoefficients(left.get<ChainLocations::Parametric>().coefficients, parametricCoefficients);
-    updateCoefficients(right.get<ChainLocations::Parametric>().coefficients, parametricCoefficients);
-}
+        ScopedTraceSpan fifoSpan(traceRecorder, TraceRecorder::AudioThread, "FIFO push");
 
-void updateCoefficients(Coefficients& old, const Coefficients &replacements)
-{
-    *old = *replacements;
-}
+        inputLeftChannelFifo.update(buffer);
+        inputRightChannelFifo.update(buffer);
+    }
 
-void ZXOEQAudioProcessor::updateLowCutFilters(const ChainParameters &chainParameters) {
+    auto chainParameters = getChainParameters(chainParameterPointers);
 
-    auto lowCutCoeffs = makeLowCutFilter(chainParameters, getSampleRate());
-    auto& leftLowCut = left.get<ChainLocations::LowCut>();
-    auto& rightLowCut = right.get<ChainLocations::LowCut>();
+    juce::dsp::AudioBlock<float> block(buffer);
+    auto mainBlock = block.getSubsetChannelBlock(0, (size_t)totalNumOutputChannels);
 
-    //left.setBypassed<ChainLocations::LowCut>(chainParameters.lowCutBypass);
-    //right.setBypassed<ChainLocations::LowCut>(chainParameters.lowCutBypass);
+    {
+        ScopedTraceSpan meterSpan(traceRecorder, TraceRecorder::AudioThread, "metering");
+        inputMeter.measure(mainBlock);
+    }
 
+    // The dynamic band keys off its own input unless an enabled sidechain is asked for
+    auto key = mainBlock;
 
-    updateCutFilter(rightLowCut, lowCutCoeffs, chainParameters.lowCutSlope);
-    updateCutFilter(leftLowCut, lowCutCoeffs, chainParameters.lowCutSlope);
-}
+    if (chainParameters.parametricSidechain && getBusCount(true) > 1 && getBus(true, 1)->isEnabled()) {
 
-void ZXOEQAudioProcessor::updateHighCutFilters(const ChainParameters& chainParameters) {
+        auto sidechainBuffer = getBusBuffer(buffer, true, 1);
 
-    auto highCutCoeffs = makeHighCutFilter(chainParameters, getSampleRate());
-    auto& leftHighCut = left.get<ChainLocations::HighCut>();
-    auto& rightHighCut = right.get<ChainLocations::HighCut>();
+        if (sidechainBuffer.getNumChannels() > 0)
+            key = juce::dsp::AudioBlock<float>(sidechainBuffer);
+    }
 
-   // left.setBypassed<ChainLocations::HighCut>(chainParameters.highCutBypass);
-   // right.setBypassed<ChainLocations::HighCut>(chainParameters.highCutBypass);
+    auto numSamples = (int)mainBlock.getNumSamples();
 
-    updateCutFilter(rightHighCut, highCutCoeffs, chainParameters.highCutSlope);
-    updateCutFilter(leftHighCut, highCutCoeffs, chainParameters.highCutSlope);
-}
+    if (isRestingAfterSilence(mainBlock)) {
 
+        // nothing runs, but the next sound should start from the current settings
+        if (chainParameters != currentChainParameters)
+            updateFilters(chainParameters);
 
-// <------------------------------------------------------------------------>
+        autoGain.skip(numSamples);
+        performanceCounters.blockSkipped();
+    }
+    else {
 
+        // The host only hands over one value per parameter and block, so with the ramp on a block
+        // that moved something is filtered in sub-blocks that walk from the last block's values
+        // to the new ones, instead of jumping at the start of a long block
+        if (chainParameters == currentChainParameters) {
 
+            processFilters(mainBlock, key);
+        }
+        else if (!chainParameters.automationRamp || numSamples <= AutomationSubBlockSize) {
 
+            updateFilters(chainParameters);
+            processFilters(mainBlock, key);
+        }
+        else {
 
+            auto previousParameters = currentChainParameters;
 
+            for (int start = 0; start < numSamples; start += AutomationSubBlockSize) {
 
-void ZXOEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
-{
-    juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels  = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
+                auto length = juce::jmin(AutomationSubBlockSize, numSamples - start);
+                auto end = start + length;
 
-    // In case we have more outputs than inputs, this code clears any output
-    // channels that didn't contain input data, (because these aren't
-    // guaranteed to be empty - they may contain garbage).
-    // This is here to avoid people getting screaming feedback
-    // when they first compile a plugin, but obviously you don't need to keep
-    // this code if your algorithm always overwrites all the output channels.
-    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-        buffer.clear (i, 0, buffer.getNumSamples());
+                if (end < numSamples)
+                    updateCoefficients(interpolateChainParameters(previousParameters, chainParameters, (float)end / (float)numSamples));
+                else
+                    updateFilters(chainParameters);
 
-    
+                processFilters(mainBlock.getSubBlock((size_t)start, (size_t)length),
+                    key.getSubBlock((size_t)start, (size_t)length));
+            }
+        }
+
+        if (autoGain.isSmoothing() || autoGain.getTargetValue() != 1.f)
+            mainBlock.multiplyBy(autoGain);
+    }
 
-    auto chainParameters = getChainParameters(state);
+    samplesSinceEstimates += numSamples;
 
-    auto parametricCoeffs = juce::dsp::IIR::Coefficients<float>::makePeakFilter(
-        getSampleRate(),
-        chainParameters.parametricFrequency,
-        chainParameters.parametricQuality,
-        juce::Decibels::decibelsToGain(chainParameters.parametricGain));
+    if (estimatesPending && samplesSinceEstimates >= estimateIntervalSamples)
+        updateEstimates(currentChainParameters);
 
+    {
+        ScopedTraceSpan meterSpan(traceRecorder, TraceRecorder::AudioThread, "metering");
+        outputMeter.measure(mainBlock);
+        loudnessMeter.measure(mainBlock);
+    }
 
-    auto lowCutCoefficients = juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(chainParameters.lowCutFrequency,
-        getSampleRate(),
-        (2 * (chainParameters.lowCutSlope + 1)));
+    {
+        ScopedTraceSpan fifoSpan(traceRecorder, TraceRecorder::AudioThread, "FIFO push");
 
-    // Left audio chain initialization -> lowCut filter chain
+        leftChannelFifo.update(buffer);
+        rightChannelFifo.update(buffer);
+    }
 
-    auto& leftLowCut = left.get<ChainLocations::LowCut>();
 
+}
 
-    // bypass positions in chain
+// Counts the silence at the input. Once it has lasted longer than the filters ring, the block is
+// cleared and the filters are put to rest, so they start from a clean state when sound comes back.
+bool ZXOEQAudioProcessor::isRestingAfterSilence(juce::dsp::AudioBlock<float>& block) {
 
-    leftLowCut.setBypassed<0>(true);
-    leftLowCut.setBypassed<1>(true);
-    leftLowCut.setBypassed<2>(true);
-    leftLowCut.setBypassed<3>(true);
-    
-    left.setBypassed<ChainLocations::LowCut>(chainParameters.lowCutBypass);
+    auto numSamples = (int)block.getNumSamples();
 
+    for (size_t ch = 0; ch < block.getNumChannels(); ++ch) {
 
+        auto range = juce::FloatVectorOperations::findMinAndMax(block.getChannelPointer(ch), numSamples);
 
-    switch (chainParameters.lowCutSlope) {
+        if (juce::jmax(-range.getStart(), range.getEnd()) > SilenceThreshold) {
 
-    case Slope_12dB:
-    {
-        *leftLowCut.get<0>().coefficients = *lowCutCoefficients[0];
-        leftLowCut.setBypassed<0>(false);
-        break;
+            silentSamples = 0;
+            isResting = false;
+            return false;
+        }
     }
 
-    case Slope_24dB:
-    {
-        *leftLowCut.get<0>().coefficients = *lowCutCoefficients[0];
-        leftLowCut.setBypassed<0>(false);
-        *leftLowCut.get<1>().coefficients = *lowCutCoefficients[1];
-        leftLowCut.setBypassed<1>(false);
-        break;
+    silentSamples += numSamples;
+
+    // the silence started before this block, it has to have outlasted the tail by its first sample,
+    // and a tail that is still to be estimated may be longer than the last one
+    if (estimatesPending || silentSamples - numSamples < tailSamples)
+        return false;
+
+    if (!isResting) {
+
+        cascade.reset();
+        svfCascade.reset();
+        dynamicSection.reset();
+        isResting = true;
     }
 
+    block.clear();
+    return true;
+}
 
+void ZXOEQAudioProcessor::processFilters(const juce::dsp::AudioBlock<float>& block, const juce::dsp::AudioBlock<float>& key) {
 
-    case Slope_36dB: {
+    if (hasDynamicParametric(currentChainParameters))
+        dynamicSection.process(block, key);
 
-        *leftLowCut.get<0>().coefficients = *lowCutCoefficients[0];
-        leftLowCut.setBypassed<0>(false);
-        *leftLowCut.get<1>().coefficients = *lowCutCoefficients[1];
-        leftLowCut.setBypassed<1>(false);
-        *leftLowCut.get<2>().coefficients = *lowCutCoefficients[2];
-        leftLowCut.setBypassed<2>(false);
-        break;
+    auto midSide = currentChainParameters.processingMode == Mode_MidSide;
+
+    if (currentChainParameters.filterEngine == Engine_StateVariable) {
+
+        svfCascade.process(block, midSide);
+        return;
     }
 
+    auto numChannels = (int)block.getNumChannels();
+    auto numSamples = (int)block.getNumSamples();
 
-    case Slope_48dB: {
-        *leftLowCut.get<0>().coefficients = *lowCutCoefficients[0];
-        leftLowCut.setBypassed<0>(false);
-        *leftLowCut.get<1>().coefficients = *lowCutCoefficients[1];
-        leftLowCut.setBypassed<1>(false);
-        *leftLowCut.get<2>().coefficients = *lowCutCoefficients[2];
-        leftLowCut.setBypassed<2>(false);
-        *leftLowCut.get<3>().coefficients = *lowCutCoefficients[3];
-        leftLowCut.setBypassed<3>(false);
-        break;
+    // The channels only meet in the mid/side matrix, so outside of it each one is a job of its own
+    if (isNonRealtime() && offlineRenderPool->isEnabled() && numChannels > 1 && numSamples >= OfflineMinimumBlockSize) {
 
-    }
+        if (midSide)
+            SectionCascade::encodeMidSide(block.getChannelPointer(0), block.getChannelPointer(1), numSamples);
+
+        offlineRenderPool->run(juce::jmin(numChannels, SectionCascade::MaxChannels), [this, &block, numSamples](int channel) {
+            juce::ScopedNoDenormals workerNoDenormals;
+            cascade.processChannel(block.getChannelPointer((size_t)channel), numSamples, channel);
+        });
+
+        if (midSide)
+            SectionCascade::decodeMidSide(block.getChannelPointer(0), block.getChannelPointer(1), numSamples);
+
+        return;
     }
 
-    auto& rightLowCut = right.get<ChainLocations::LowCut>();
+    cascade.process(block, midSide);
+}
 
-    
+//==============================================================================
+bool ZXOEQAudioProcessor::hasEditor() const
+{
+    return true; // (change this to false if you choose to not supply an editor)
+}
 
+juce::AudioProcessorEditor* ZXOEQAudioProcessor::createEditor()
+{
+    //return new juce::GenericAudioProcessorEditor(*this);
+    return new ZXOEQAudioProcessorEditor (*this);
+}
 
-    // bypass positions in chain
+//==============================================================================
+void ZXOEQAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
+{
+    // You should use this method to store your parameters in the memory block.
+    // You could do that either as raw data, or use the XML or ValueTree classes
+    // as intermediaries to make it easy to save and load complex data.
+}
 
-    rightLowCut.setBypassed<0>(true);
-    rightLowCut.setBypassed<1>(true);
-    rightLowCut.setBypassed<2>(true);
-    rightLowCut.setBypassed<3>(true);
-    // leftLowCut.setBypassed<4>(true); <-- array out of index issue
+void ZXOEQAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    // You should use this method to restore your parameters from this memory block,
+    // whose contents will have been created by the getStateInformation() call.
+}
 
-    right.setBypassed<ChainLocations::LowCut>(chainParameters.lowCutBypass);
 
-    switch (chainParameters.lowCutSlope) {
+ChainParameterPointers::ChainParameterPointers(juce::AudioProcessorValueTreeState& state) {
 
-    case Slope_12dB:
-    {
-        *rightLowCut.get<0>().coefficients = *lowCutCoefficients[0];
-        rightLowCut.setBypassed<0>(false);
-        break;
-    }
+    auto get = [&state](const juce::String& id) {
 
-    case Slope_24dB:
-    {
-        *rightLowCut.get<0>().coefficients = *lowCutCoefficients[0];
-        rightLowCut.setBypassed<0>(false);
-        *rightLowCut.get<1>().coefficients = *lowCutCoefficients[1];
-        rightLowCut.setBypassed<1>(false);
-        break;
-    }
+        auto* value = state.getRawParameterValue(id);
+        jassert(value != nullptr);
 
+        return value;
+    };
 
+    lowCutFrequency = get("LowCut Frequency");
+    lowCutSlope = get("LowCut Slope");
+    lowCutResponse = get("LowCut Response");
+    lowCutBypass = get("LowCut Bypass");
+    highCutFrequency = get("HighCut Frequency");
+    highCutSlope = get("HighCut Slope");
+    highCutResponse = get("HighCut Response");
+    highCutBypass = get("HighCut Bypass");
 
-    case Slope_36dB: {
+    parametricFrequency = get("Parametric Frequency");
+    parametricGain = get("Parametric Gain");
+    parametricQuality = get("Parametric Quality");
+    parametricBypass = get("Parametric Bypass");
+    parametricDynamic = get("Parametric Dynamic");
+    parametricSidechain = get("Parametric Sidechain");
+    parametricThreshold = get("Parametric Threshold");
+    parametricRatio = get("Parametric Ratio");
+    parametricAttack = get("Parametric Attack");
+    parametricRelease = get("Parametric Release");
 
-        *rightLowCut.get<0>().coefficients = *lowCutCoefficients[0];
-        rightLowCut.setBypassed<0>(false);
-        *rightLowCut.get<1>().coefficients = *lowCutCoefficients[1];
-        rightLowCut.setBypassed<1>(false);
-        *rightLowCut.get<2>().coefficients = *lowCutCoefficients[2];
-        rightLowCut.setBypassed<2>(false);
-        break;
-    }
+    processingMode = get("Processing Mode");
+    filterEngine = get("Filter Engine");
+    autoGain = get("Auto Gain");
+    automationRamp = get("Automation Ramp");
 
+    const auto& bandIDs = getBandParameterIDs();
 
-    case Slope_48dB: {
-        *rightLowCut.get<0>().coefficients = *lowCutCoefficients[0];
-        rightLowCut.setBypassed<0>(false);
-        *rightLowCut.get<1>().coefficients = *lowCutCoefficients[1];
-        rightLowCut.setBypassed<1>(false);
-        *rightLowCut.get<2>().coefficients = *lowCutCoefficients[2];
-        rightLowCut.setBypassed<2>(false);
-        *rightLowCut.get<3>().coefficients = *lowCutCoefficients[3];
-        rightLowCut.setBypassed<3>(false);
-        break;
+    for (int i = 0; i < MaxBands; ++i) {
 
-    }
+        auto& band = bands[i];
+        const auto& ids = bandIDs[i];
 
+        band.type = get(ids.type);
+        band.frequency = get(ids.frequency);
+        band.gain = get(ids.gain);
+        band.quality = get(ids.quality);
+        band.bypass = get(ids.bypass);
+        band.slope = get(ids.slope);
+        band.channel = get(ids.channel);
     }
+}
 
-    // FOR HIGH CUT ( LOW PASS HIGH ORDER)
-    auto highCutCoefficients = juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(chainParameters.highCutFrequency,
-        getSampleRate(),
-        (2 * (chainParameters.highCutSlope + 1)));
+ChainParameters getChainParameters(const ChainParameterPointers& pointers) {
 
-    auto& leftHighCut = left.get<ChainLocations::HighCut>();
+    ChainParameters parameters;
 
-   
+    parameters.lowCutFrequency = pointers.lowCutFrequency->load();
+    parameters.lowCutSlope = static_cast<SlopeValues>(pointers.lowCutSlope->load());
+    parameters.highCutFrequency = pointers.highCutFrequency->load();
+    parameters.highCutSlope = static_cast<SlopeValues>(pointers.highCutSlope->load());
 
+    parameters.lowCutResponse = static_cast<CutResponse>(pointers.lowCutResponse->load());
+    parameters.highCutResponse = static_cast<CutResponse>(pointers.highCutResponse->load());
 
-    leftHighCut.setBypassed<0>(true);
-    leftHighCut.setBypassed<1>(true);
-    leftHighCut.setBypassed<2>(true);
-    leftHighCut.setBypassed<3>(true);
+    parameters.processingMode = static_cast<ProcessingMode>(pointers.processingMode->load());
+    parameters.filterEngine = static_cast<FilterEngine>(pointers.filterEngine->load());
 
-    left.setBypassed<ChainLocations::HighCut>(chainParameters.highCutBypass);
+    parameters.autoGain = pointers.autoGain->load() > 0.5f;
+    parameters.automationRamp = pointers.automationRamp->load() > 0.5f;
 
-    switch (chainParameters.highCutSlope) {
+    parameters.parametricDynamic = pointers.parametricDynamic->load() > 0.5f;
+    parameters.parametricSidechain = pointers.parametricSidechain->load() > 0.5f;
+    parameters.parametricThreshold = pointers.parametricThreshold->load();
+    parameters.parametricRatio = pointers.parametricRatio->load();
+    parameters.parametricAttack = pointers.parametricAttack->load();
+    parameters.parametricRelease = pointers.parametricRelease->load();
+    parameters.parametricFrequency = pointers.parametricFrequency->load();
+    parameters.parametricGain = pointers.parametricGain->load();
+    parameters.parametricQuality = pointers.parametricQuality->load();
 
-    case Slope_12dB:
-    {
-        *leftHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        leftHighCut.setBypassed<0>(false);
-        break;
-    }
+    parameters.lowCutBypass = pointers.lowCutBypass->load() > 0.5f;
+    parameters.highCutBypass = pointers.highCutBypass->load() > 0.5f;
 
-    case Slope_24dB:
-    {
-        *leftHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        leftHighCut.setBypassed<0>(false);
-        *leftHighCut.get<1>().coefficients = *highCutCoefficients[1];
-        leftHighCut.setBypassed<1>(false);
-        break;
+    parameters.parametricBypass = pointers.parametricBypass->load() > 0.5f;
+
+    for (int i = 0; i < MaxBands; ++i) {
+
+        auto& band = parameters.bands[i];
+        const auto& values = pointers.bands[i];
+
+        band.type = static_cast<BandType>(values.type->load());
+        band.frequency = values.frequency->load();
+        band.gain = values.gain->load();
+        band.quality = values.quality->load();
+        band.bypass = values.bypass->load() > 0.5f;
+        band.slope = static_cast<SlopeValues>(values.slope->load());
+        band.channel = static_cast<BandChannel>(values.channel->load());
     }
 
+    return parameters;
+}
 
+ChainParameters getChainParameters(juce::AudioProcessorValueTreeState& state) {
 
-    case Slope_36dB: {
+    return getChainParameters(ChainParameterPointers(state));
+}
 
-        *leftHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        leftHighCut.setBypassed<0>(false);
-        *leftHighCut.get<1>().coefficients = *highCutCoefficients[1];
-        leftHighCut.setBypassed<1>(false);
-        *leftHighCut.get<2>().coefficients = *highCutCoefficients[2];
-        leftHighCut.setBypassed<2>(false);
-        break;
-    }
+bool operator==(const BandParameters& a, const BandParameters& b) {
 
+    return a.frequency == b.frequency
+        && a.gain == b.gain
+        && a.quality == b.quality
+        && a.bypass == b.bypass
+        && a.type == b.type
+        && a.slope == b.slope
+        && a.channel == b.channel;
+}
 
-    case Slope_48dB: {
-        *leftHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        leftHighCut.setBypassed<0>(false);
-        *leftHighCut.get<1>().coefficients = *highCutCoefficients[1];
-        leftHighCut.setBypassed<1>(false);
-        *leftHighCut.get<2>().coefficients = *highCutCoefficients[2];
-        leftHighCut.setBypassed<2>(false);
-        *leftHighCut.get<3>().coefficients = *highCutCoefficients[3];
-        leftHighCut.setBypassed<3>(false);
-        break;
+bool operator==(const ChainParameters& a, const ChainParameters& b) {
+
+    return a.parametricFrequency == b.parametricFrequency
+        && a.parametricGain == b.parametricGain
+        && a.parametricQuality == b.parametricQuality
+        && a.lowCutFrequency == b.lowCutFrequency
+        && a.highCutFrequency == b.highCutFrequency
+        && a.lowCutBypass == b.lowCutBypass
+        && a.parametricBypass == b.parametricBypass
+        && a.highCutBypass == b.highCutBypass
+        && a.parametricDynamic == b.parametricDynamic
+        && a.parametricSidechain == b.parametricSidechain
+        && a.parametricThreshold == b.parametricThreshold
+        && a.parametricRatio == b.parametricRatio
+        && a.parametricAttack == b.parametricAttack
+        && a.parametricRelease == b.parametricRelease
+        && a.lowCutSlope == b.lowCutSlope
+        && a.highCutSlope == b.highCutSlope
+        && a.lowCutResponse == b.lowCutResponse
+        && a.highCutResponse == b.highCutResponse
+        && a.processingMode == b.processingMode
+        && a.filterEngine == b.filterEngine
+        && a.autoGain == b.autoGain
+        && a.automationRamp == b.automationRamp
+        && a.bands == b.bands;
+}
 
-    }
-    }
+ChainParameters interpolateChainParameters(const ChainParameters& from, const ChainParameters& to, float amount) {
 
-    auto& rightHighCut = right.get<ChainLocations::HighCut>();
+    auto linear = [amount](float a, float b) { return a + (b - a) * amount; };
+    auto logarithmic = [amount](float a, float b) { return a > 0.f && b > 0.f ? a * std::pow(b / a, amount) : b; };
 
-    
+    auto parameters = to;
 
+    parameters.lowCutFrequency = logarithmic(from.lowCutFrequency, to.lowCutFrequency);
+    parameters.highCutFrequency = logarithmic(from.highCutFrequency, to.highCutFrequency);
 
-    rightHighCut.setBypassed<0>(true);
-    rightHighCut.setBypassed<1>(true);
-    rightHighCut.setBypassed<2>(true);
-    rightHighCut.setBypassed<3>(true);
+    parameters.parametricFrequency = logarithmic(from.parametricFrequency, to.parametricFrequency);
+    parameters.parametricGain = linear(from.parametricGain, to.parametricGain);
+    parameters.parametricQuality = logarithmic(from.parametricQuality, to.parametricQuality);
+    parameters.parametricThreshold = linear(from.parametricThreshold, to.parametricThreshold);
+    parameters.parametricRatio = linear(from.parametricRatio, to.parametricRatio);
 
-    right.setBypassed<ChainLocations::HighCut>(chainParameters.highCutBypass);
+    for (int i = 0; i < MaxBands; ++i) {
 
+        const auto& a = from.bands[i];
+        auto& band = parameters.bands[i];
 
-    switch (chainParameters.highCutSlope) {
+        if (a.type != band.type || a.bypass != band.bypass || a.slope != band.slope || a.channel != band.channel)
+            continue;
 
-    case Slope_12dB:
-    {
-        *rightHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        rightHighCut.setBypassed<0>(false);
-        break;
+        band.frequency = logarithmic(a.frequency, band.frequency);
+        band.gain = linear(a.gain, band.gain);
+        band.quality = logarithmic(a.quality, band.quality);
     }
 
-    case Slope_24dB:
-    {
-        *rightHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        rightHighCut.setBypassed<0>(false);
-        *rightHighCut.get<1>().coefficients = *highCutCoefficients[1];
-        rightHighCut.setBypassed<1>(false);
-        break;
-    }
+    return parameters;
+}
 
+int ZXOEQAudioProcessor::applySpectrumMatch() {
 
+    const auto& bandIDs = getBandParameterIDs();
 
-    case Slope_36dB: {
+    std::vector<int> freeBands;
 
-        *rightHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        rightHighCut.setBypassed<0>(false);
-        *rightHighCut.get<1>().coefficients = *highCutCoefficients[1];
-        rightHighCut.setBypassed<1>(false);
-        *rightHighCut.get<2>().coefficients = *highCutCoefficients[2];
-        rightHighCut.setBypassed<2>(false);
-        break;
+    for (int i = 0; i < MaxBands; ++i) {
+        if (state.getRawParameterValue(bandIDs[i].bypass)->load() > 0.5f) {
+            freeBands.push_back(i);
+        }
     }
 
+    auto fittedBands = spectrumMatch->fit((int)freeBands.size());
 
-    case Slope_48dB: {
-        *rightHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        rightHighCut.setBypassed<0>(false);
-        *rightHighCut.get<1>().coefficients = *highCutCoefficients[1];
-        rightHighCut.setBypassed<1>(false);
-        *rightHighCut.get<2>().coefficients = *highCutCoefficients[2];
-        rightHighCut.setBypassed<2>(false);
-        *rightHighCut.get<3>().coefficients = *highCutCoefficients[3];
-        rightHighCut.setBypassed<3>(false);
-        break;
+    auto setParameter = [this](const juce::String& parameterID, float value) {
+        if (auto* parameter = state.getParameter(parameterID)) {
+            parameter->beginChangeGesture();
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+            parameter->endChangeGesture();
+        }
+    };
 
-    }
+    for (size_t i = 0; i < fittedBands.size(); ++i) {
+
+        const auto& ids = bandIDs[freeBands[i]];
+        const auto& band = fittedBands[i];
+
+        setParameter(ids.type, (float)Band_Peak);
+        setParameter(ids.channel, (float)BandChannel_Both);
+        setParameter(ids.frequency, band.frequency);
+        setParameter(ids.gain, band.gain);
+        setParameter(ids.quality, band.quality);
+        setParameter(ids.bypass, 0.f);
     }
 
-    *left.get<ChainLocations::Parametric>().coefficients = *parametricCoeffs;
-    *right.get<ChainLocations::Parametric>().coefficients = *parametricCoeffs;
-    
-    
+    return (int)fittedBands.size();
+}
 
-    left.setBypassed<ChainLocations::Parametric>(chainParameters.parametricBypass);
-    right.setBypassed<ChainLocations::Parametric>(chainParameters.parametricBypass);
+juce::StringArray getBandTypeNames() {
 
+    return { "Peak", "Notch", "Band Pass", "Tilt", "Low Shelf", "High Shelf" };
+}
 
-    juce::dsp::AudioBlock<float> block(buffer);
+juce::StringArray getProcessingModeNames() {
+
+    return { "Stereo", "Left / Right", "Mid / Side" };
+}
 
-    auto leftB = block.getSingleChannelBlock(0);
-    auto rightB = block.getSingleChannelBlock(1);
+juce::StringArray getCutResponseNames() {
 
-    juce::dsp::ProcessContextReplacing<float> leftContext(leftB);
-    juce::dsp::ProcessContextReplacing<float> rightContext(rightB);
+    return { "Butterworth", "Linkwitz-Riley", "Bessel", "Chebyshev", "Elliptic" };
+}
 
-    left.process(leftContext);
-    right.process(rightContext);
+juce::StringArray getFilterEngineNames() {
 
-    leftChannelFifo.update(buffer);
-    rightChannelFifo.update(buffer);
+    return { "Biquad", "SVF" };
+}
 
+juce::StringArray getAnalyzerViewNames() {
 
+    return { "Spectrum", "Spectrogram" };
 }
 
-//==============================================================================
-bool ZXOEQAudioProcessor::hasEditor() const
-{
-    return true; // (change this to false if you choose to not supply an editor)
+juce::StringArray getAnalyzerSourceNames() {
+
+    return { "Output", "Input", "Difference" };
 }
 
-juce::AudioProcessorEditor* ZXOEQAudioProcessor::createEditor()
-{
-    //return new juce::GenericAudioProcessorEditor(*this);
-    return new ZXOEQAudioProcessorEditor (*this);
+juce::StringArray getFrameRateNames() {
+
+    return { "15 fps", "30 fps", "60 fps", "Display" };
 }
 
-//==============================================================================
-void ZXOEQAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
-{
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+const std::array<double, 4>& getFrameRateCaps() {
+
+    static const std::array<double, 4> caps{ 15.0, 30.0, 60.0, 1000.0 };
+    return caps;
 }
 
-void ZXOEQAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
-{
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+juce::StringArray getBandChannelNames() {
+
+    return { "Both", "Left / Mid", "Right / Side" };
 }
 
+juce::String getBandParameterID(int bandIndex, const juce::String& name) {
 
-ChainParameters getChainParameters(juce::AudioProcessorValueTreeState& state) {
+    return "Band " + juce::String(bandIndex + 1) + " " + name;
+}
 
-    ChainParameters parameters;
+// The IDs are built once so reading the bands on the audio thread doesn't allocate
+const std::array<BandParameterIDs, MaxBands>& getBandParameterIDs() {
 
-    parameters.lowCutFrequency = state.getRawParameterValue("LowCut Frequency")->load();
-    parameters.lowCutSlope = static_cast<SlopeValues>(state.getRawParameterValue("LowCut Slope")->load());
-    parameters.highCutFrequency = state.getRawParameterValue("HighCut Frequency")->load();
-    parameters.highCutSlope = static_cast<SlopeValues>(state.getRawParameterValue("HighCut Slope")->load());
-    parameters.parametricFrequency = state.getRawParameterValue("Parametric Frequency")->load();
-    parameters.parametricGain = state.getRawParameterValue("Parametric Gain")->load();
-    parameters.parametricQuality = state.getRawParameterValue("Parametric Quality")->load();
+    static const auto ids = []() {
 
-    parameters.lowCutBypass = state.getRawParameterValue("LowCut Bypass")->load() > 0.5f;
-    parameters.highCutBypass = state.getRawParameterValue("HighCut Bypass")->load() > 0.5f;
+        std::array<BandParameterIDs, MaxBands> result;
 
-    parameters.parametricBypass = state.getRawParameterValue("Parametric Bypass")->load() > 0.5f;
+        for (int i = 0; i < MaxBands; ++i) {
+            result[i].type = getBandParameterID(i, "Type");
+            result[i].frequency = getBandParameterID(i, "Frequency");
+            result[i].gain = getBandParameterID(i, "Gain");
+            result[i].quality = getBandParameterID(i, "Quality");
+            result[i].bypass = getBandParameterID(i, "Bypass");
+            result[i].slope = getBandParameterID(i, "Slope");
+            result[i].channel = getBandParameterID(i, "Channel");
+        }
 
+        return result;
+    }();
 
-    return parameters;
+    return ids;
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout ZXOEQAudioProcessor::createParameterLayout() {
@@ -848,7 +945,7 @@ juce::AudioProcessorValueTreeState::ParameterLayout ZXOEQAudioProcessor::createP
 
     juce::StringArray values;
 
-    for (auto i = 0; i < 4; ++i) {
+    for (auto i = 0; i < MaxCutSections; ++i) {
 
         juce::String string;
         string << (12 + (i * 12));
@@ -856,11 +953,25 @@ juce::AudioProcessorValueTreeState::ParameterLayout ZXOEQAudioProcessor::createP
         values.add(string);
     }
 
+    // shelves stop at 48 dB per octave
+    juce::StringArray shelfValues;
+
+    for (auto i = 0; i < MaxSectionsPerBand; ++i) {
+        shelfValues.add(values[i]);
+    }
+
     layout.add(std::make_unique<juce::AudioParameterChoice>("LowCut Slope", "LowCut Slope", values, 0));
     layout.add(std::make_unique<juce::AudioParameterChoice>("HighCut Slope", "HighCut Slope", values, 0));
 
+    layout.add(std::make_unique<juce::AudioParameterChoice>("LowCut Response", "LowCut Response", getCutResponseNames(), 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("HighCut Response", "HighCut Response", getCutResponseNames(), 0));
+
 
     layout.add(std::make_unique<juce::AudioParameterBool>("Analyzer Enabled", "Analyzer Enabled", true));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Analyzer View", "Analyzer View", getAnalyzerViewNames(), 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Analyzer Source", "Analyzer Source", getAnalyzerSourceNames(), Source_Output));
+    layout.add(std::make_unique<juce::AudioParameterBool>("OpenGL Rendering", "OpenGL Rendering", false));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Display Frame Rate", "Display Frame Rate", getFrameRateNames(), 2));
 
     
     layout.add(std::make_unique<juce::AudioParameterBool>("LowCut Bypass", "LowCut Bypass", false));
@@ -868,6 +979,36 @@ juce::AudioProcessorValueTreeState::ParameterLayout ZXOEQAudioProcessor::createP
 
     layout.add(std::make_unique<juce::AudioParameterBool>("HighCut Bypass", "HighCut Bypass", false));
 
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Processing Mode", "Processing Mode", getProcessingModeNames(), 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Filter Engine", "Filter Engine", getFilterEngineNames(), 0));
+    layout.add(std::make_unique<juce::AudioParameterBool>("Auto Gain", "Auto Gain", false));
+    layout.add(std::make_unique<juce::AudioParameterBool>("Automation Ramp", "Automation Ramp", false));
+
+    layout.add(std::make_unique<juce::AudioParameterBool>("Parametric Dynamic", "Parametric Dynamic", false));
+    layout.add(std::make_unique<juce::AudioParameterBool>("Parametric Sidechain", "Parametric Sidechain", false));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Parametric Threshold", "Parametric Threshold", juce::NormalisableRange<float>(-60.f, 0.f, 0.5f, 1.f), -20.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Parametric Ratio", "Parametric Ratio", juce::NormalisableRange<float>(1.f, 20.f, 0.1f, .4f), 2.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Parametric Attack", "Parametric Attack", juce::NormalisableRange<float>(0.1f, 200.f, 0.1f, .4f), 10.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Parametric Release", "Parametric Release", juce::NormalisableRange<float>(5.f, 2000.f, 1.f, .4f), 150.f));
+
+    // Extra bands start bypassed and spread over the spectrum so they are easy to pick up
+    const auto& bandIDs = getBandParameterIDs();
+
+    for (int i = 0; i < MaxBands; ++i) {
+
+        const auto& ids = bandIDs[i];
+        auto defaultFrequency = juce::mapToLog10((i + 0.5f) / float(MaxBands), 20.f, 20000.f);
+
+        layout.add(std::make_unique<juce::AudioParameterChoice>(ids.type, ids.type, getBandTypeNames(), 0));
+        layout.add(std::make_unique<juce::AudioParameterFloat>(ids.frequency, ids.frequency, juce::NormalisableRange<float>(20.f, 20000.f, 1.f, .25f), defaultFrequency));
+        layout.add(std::make_unique<juce::AudioParameterFloat>(ids.gain, ids.gain, juce::NormalisableRange<float>(-30.f, 30.f, 0.25f, 1.f), 0.0f));
+        layout.add(std::make_unique<juce::AudioParameterFloat>(ids.quality, ids.quality, juce::NormalisableRange<float>(0.1f, 15.f, 0.05f, 1.f), 1.f));
+        layout.add(std::make_unique<juce::AudioParameterBool>(ids.bypass, ids.bypass, true));
+        layout.add(std::make_unique<juce::AudioParameterChoice>(ids.slope, ids.slope, shelfValues, 0));
+        layout.add(std::make_unique<juce::AudioParameterChoice>(ids.channel, ids.channel, getBandChannelNames(), 0));
+    }
+
 
     return layout;
 }
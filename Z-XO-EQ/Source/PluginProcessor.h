@@ -10,6 +10,14 @@
 
 #include <array>
 #include <JuceHeader.h>
+#include "PerformanceCounters.h"
+#include "TraceRecorder.h"
+#include "SectionCascade.h"
+#include "SvfCascade.h"
+#include "DynamicSection.h"
+#include "OfflineRenderPool.h"
+#include "LevelMeter.h"
+#include "LoudnessMeter.h"
 
 
 enum SlopeValues {
@@ -17,7 +25,64 @@ enum SlopeValues {
     Slope_12dB,
     Slope_24dB,
     Slope_36dB,
-    Slope_48dB
+    Slope_48dB,
+    Slope_60dB,
+    Slope_72dB,
+    Slope_84dB,
+    Slope_96dB
+};
+
+enum BandType {
+
+    Band_Peak,
+    Band_Notch,
+    Band_BandPass,
+    Band_Tilt,
+    Band_LowShelf,
+    Band_HighShelf
+};
+
+enum ProcessingMode {
+
+    Mode_Stereo,
+    Mode_LeftRight,
+    Mode_MidSide
+};
+
+// Biquads swap their coefficients when the settings change, the state variable filters ramp into them
+enum FilterEngine {
+
+    Engine_Biquad,
+    Engine_StateVariable
+};
+
+// What the analyzer shows, the difference is the output over the input, bin by bin
+enum AnalyzerSource {
+
+    Source_Output,
+    Source_Input,
+    Source_Difference
+};
+
+// Which channel an extra band runs on outside of stereo mode, left/mid or right/side
+enum BandChannel {
+
+    BandChannel_Both,
+    BandChannel_First,
+    BandChannel_Second
+};
+
+struct BandParameters {
+
+    float frequency{ 1000.f };
+    float gain{ 0 };
+    float quality{ 1.f };
+
+    bool bypass{ true };
+
+    BandType type{ BandType::Band_Peak };
+    SlopeValues slope{ SlopeValues::Slope_12dB };
+    BandChannel channel{ BandChannel::BandChannel_Both };
 };
 
 struct ChainParameters {
@@ -32,12 +97,37 @@ struct ChainParameters {
     bool parametricBypass{ false };
     bool highCutBypass{ false };
 
+    // the parametric band can follow a detector instead of sitting at a fixed gain
+    bool parametricDynamic{ false };
+    bool parametricSidechain{ false };
+    float parametricThreshold{ -20.f };
+    float parametricRatio{ 2.f };
+    float parametricAttack{ 10.f };
+    float parametricRelease{ 150.f };
+
     SlopeValues  lowCutSlope{ SlopeValues::Slope_12dB };
     SlopeValues  highCutSlope{ SlopeValues::Slope_12dB };
 
+    CutResponse lowCutResponse{ CutResponse::Cut_Butterworth };
+    CutResponse highCutResponse{ CutResponse::Cut_Butterworth };
+
+    ProcessingMode processingMode{ ProcessingMode::Mode_Stereo };
+
+    FilterEngine filterEngine{ FilterEngine::Engine_Biquad };
+
+    bool autoGain{ false };
+
+    // ramp the parameters through a block in sub-blocks instead of stepping once per block
+    bool automationRamp{ false };
+
+    std::array<BandParameters, MaxBands> bands;
 };
 
+bool operator==(const BandParameters& a, const BandParameters& b);
+bool operator==(const ChainParameters& a, const ChainParameters& b);
 
+inline bool operator!=(const BandParameters& a, const BandParameters& b) { return !(a == b); }
+inline bool operator!=(const ChainParameters& a, const ChainParameters& b) { return !(a == b); }
 
 
 template<typename T>
@@ -149,10 +239,30 @@ struct SingleChannelSampleFifo
     bool isPrepared() const { return prepared.get(); }
     int getSize() const { return size.get(); }
     //==============================================================================
-    bool getAudioBuffer(BlockType& buf) { return audioBufferFifo.pull(buf); }
+    bool getAudioBuffer(BlockType& buf)
+    {
+        while (audioBufferFifo.pull(buf))
+        {
+            // buffers queued before a restart belong to an earlier stretch of audio
+            if (++numBuffersPulled > restartBuffer.get())
+                return true;
+        }
+
+        return false;
+    }
+
+    // audio thread only, the next buffer starts at the next sample
+    void restart()
+    {
+        fifoIndex = 0;
+        restartBuffer.set(numBuffersPushed);
+    }
 private:
     Channel channelToUse;
     int fifoIndex = 0;
+    juce::int64 numBuffersPushed = 0;
+    juce::int64 numBuffersPulled = 0;
+    juce::Atomic<juce::int64> restartBuffer = 0;
     Fifo<BlockType> audioBufferFifo;
     BlockType bufferToFill;
     juce::Atomic<bool> prepared = false;
@@ -162,9 +272,8 @@ private:
     {
         if (fifoIndex == bufferToFill.getNumSamples())
         {
-            auto ok = audioBufferFifo.push(bufferToFill);
-
-            juce::ignoreUnused(ok);
+            if (audioBufferFifo.push(bufferToFill))
+                ++numBuffersPushed;
 
             fifoIndex = 0;
         }
@@ -174,80 +283,183 @@ private:
     }
 };
 
-ChainParameters getChainParameters(juce::AudioProcessorValueTreeState& state);
+enum FFTOrder
+{
+    order2048 = 11,
+    order4096 = 12,
+    order8192 = 13,
+    order16384 = 14
+};
+
+template<typename BlockType>
+struct FFTDataGenerator
+{
+    /**
+     produces the FFT data from an audio buffer.
+     */
+    void produceFFTDataForRendering(const juce::AudioBuffer<float>& audioData, const float negativeInfinity)
+    {
+        const auto fftSize = getFFTSize();
+
+        fftData.assign(fftData.size(), 0);
+        auto* readIndex = audioData.getReadPointer(0);
+        std::copy(readIndex, readIndex + fftSize, fftData.begin());
+
+        // first apply a windowing function to our data
+        window->multiplyWithWindowingTable(fftData.data(), fftSize);       // [1]
+
+        // then render our FFT data..
+        forwardFFT->performFrequencyOnlyForwardTransform(fftData.data());  // [2]
+
+        int numBins = (int)fftSize / 2;
+
+        //normalize the fft values.
+        for (int i = 0; i < numBins; ++i)
+        {
+            auto v = fftData[i];
+            //            fftData[i] /= (float) numBins;
+            if (!std::isinf(v) && !std::isnan(v))
+            {
+                v /= float(numBins);
+            }
+            else
+            {
+                v = 0.f;
+            }
+            fftData[i] = v;
+        }
+
+        //convert them to decibels
+        for (int i = 0; i < numBins; ++i)
+        {
+            fftData[i] = juce::Decibels::gainToDecibels(fftData[i], negativeInfinity);
+        }
+
+        fftDataFifo.push(fftData);
+    }
 
-using Filter = juce::dsp::IIR::Filter<float>;
+    void changeOrder(FFTOrder newOrder)
+    {
+        //when you change order, recreate the window, forwardFFT, fifo, fftData
+        //also reset the fifoIndex
+        //things that need recreating should be created on the heap via std::make_unique<>
 
-using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
+        order = newOrder;
+        auto fftSize = getFFTSize();
 
-using MonoChain = juce::dsp::ProcessorChain < CutFilter, Filter, CutFilter >;
+        forwardFFT = std::make_unique<juce::dsp::FFT>(order);
+        window = std::make_unique<juce::dsp::WindowingFunction<float>>(fftSize, juce::dsp::WindowingFunction<float>::blackmanHarris);
 
+        fftData.clear();
+        fftData.resize(fftSize * 2, 0);
 
-enum ChainLocations {
+        fftDataFifo.prepare(fftData.size());
+    }
+    //==============================================================================
+    int getFFTSize() const { return 1 << order; }
+    int getNumAvailableFFTDataBlocks() const { return fftDataFifo.getNumAvailableForReading(); }
+    //==============================================================================
+    bool getFFTData(BlockType& fftData) { return fftDataFifo.pull(fftData); }
+private:
+    FFTOrder order;
+    BlockType fftData;
+    std::unique_ptr<juce::dsp::FFT> forwardFFT;
+    std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
 
-    LowCut,
-    Parametric,
-    HighCut
+    Fifo<BlockType> fftDataFifo;
 };
 
+// The values getChainParameters reads, looked up by ID once rather than every time they are read
+struct ChainParameterPointers {
+
+    explicit ChainParameterPointers(juce::AudioProcessorValueTreeState& state);
+
+    struct Band {
+
+        std::atomic<float>* type;
+        std::atomic<float>* frequency;
+        std::atomic<float>* gain;
+        std::atomic<float>* quality;
+        std::atomic<float>* bypass;
+        std::atomic<float>* slope;
+        std::atomic<float>* channel;
+    };
+
+    std::atomic<float>* lowCutFrequency;
+    std::atomic<float>* lowCutSlope;
+    std::atomic<float>* lowCutResponse;
+    std::atomic<float>* lowCutBypass;
+    std::atomic<float>* highCutFrequency;
+    std::atomic<float>* highCutSlope;
+    std::atomic<float>* highCutResponse;
+    std::atomic<float>* highCutBypass;
+
+    std::atomic<float>* parametricFrequency;
+    std::atomic<float>* parametricGain;
+    std::atomic<float>* parametricQuality;
+    std::atomic<float>* parametricBypass;
+    std::atomic<float>* parametricDynamic;
+    std::atomic<float>* parametricSidechain;
+    std::atomic<float>* parametricThreshold;
+    std::atomic<float>* parametricRatio;
+    std::atomic<float>* parametricAttack;
+    std::atomic<float>* parametricRelease;
+
+    std::atomic<float>* processingMode;
+    std::atomic<float>* filterEngine;
+    std::atomic<float>* autoGain;
+    std::atomic<float>* automationRamp;
+
+    std::array<Band, MaxBands> bands;
+};
 
-using Coefficients = Filter::CoefficientsPtr;
+ChainParameters getChainParameters(const ChainParameterPointers& pointers);
+ChainParameters getChainParameters(juce::AudioProcessorValueTreeState& state);
 
-void updateCoefficients(Coefficients& old, const Coefficients& replacements);
+juce::File getDiagnosticsDirectory(const char* environmentVariable);
 
-Coefficients makeParametricFilter(const ChainParameters& chainParameters, double sampleRate);
+juce::StringArray getBandTypeNames();
 
+juce::StringArray getProcessingModeNames();
 
-inline auto makeLowCutFilter(const ChainParameters& chainParameters, double sampleRate) {
-    return juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(chainParameters.lowCutFrequency,
-        sampleRate,
-        (2 * (chainParameters.lowCutSlope + 1)));
-}
+juce::StringArray getCutResponseNames();
 
-inline auto makeHighCutFilter(const ChainParameters& chainParameters, double sampleRate) {
-    return juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(chainParameters.highCutFrequency,
-        sampleRate,
-        (2 * (chainParameters.highCutSlope + 1)));
-}
+juce::StringArray getFilterEngineNames();
 
-template<int Index, typename ChainType, typename CoefficientType>
-void update(ChainType& chain, const CoefficientType& coefficients)
-{
-    updateCoefficients(chain.template get<Index>().coefficients, coefficients[Index]);
-    chain.template setBypassed<Index>(false);
-}
-
-template<typename ChainType, typename CoefficientType>
-void updateCutFilter(ChainType& chain,
-    const CoefficientType& coefficients,
-    const SlopeValues& slope)
-{
-    chain.template setBypassed<0>(true);
-    chain.template setBypassed<1>(true);
-    chain.template setBypassed<2>(true);
-    chain.template setBypassed<3>(true);
+juce::StringArray getAnalyzerViewNames();
 
-    switch (slope)
-    {
-    case Slope_48dB:
-    {
-        update<3>(chain, coefficients);
-    }
-    case Slope_36dB:
-    {
-        update<2>(chain, coefficients);
-    }
-    case Slope_24dB:
-    {
-        update<1>(chain, coefficients);
-    }
-    case Slope_12dB:
-    {
-        update<0>(chain, coefficients);
-    }
-    }
-}
+juce::StringArray getAnalyzerSourceNames();
+
+// Caps for the editor's frame rate, the last one follows the display
+juce::StringArray getFrameRateNames();
+const std::array<double, 4>& getFrameRateCaps();
+
+juce::StringArray getBandChannelNames();
+
+juce::String getBandParameterID(int bandIndex, const juce::String& name);
+
+struct BandParameterIDs {
+
+    juce::String type;
+    juce::String frequency;
+    juce::String gain;
+    juce::String quality;
+    juce::String bypass;
+    juce::String slope;
+    juce::String channel;
+};
+
+const std::array<BandParameterIDs, MaxBands>& getBandParameterIDs();
+
+// Appends every active filter of the chain, bypassed ones are left out entirely.
+// The audio thread runs a dynamic parametric band on its own, so it can leave it out too.
+void makeChainSections(const ChainParameters& chainParameters, SectionList& sections, bool includeDynamicBands = true);
 
+// The parameters a fraction of the way from one block to the next. Frequencies and qualities
+// move on a log scale, anything that switches a filter or changes its shape jumps straight away.
+ChainParameters interpolateChainParameters(const ChainParameters& from, const ChainParameters& to, float amount);
+
+class SpectrumMatch;
 
 class ZXOEQAudioProcessor  : public juce::AudioProcessor
 {
@@ -289,9 +501,10 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
-    void updateParametricFilter(const ChainParameters& chainParameters);
-    void updateLowCutFilters(const ChainParameters& chainParameters);
-    void updateHighCutFilters(const ChainParameters& chainParameters);
+    void updateFilters(const ChainParameters& chainParameters);
+
+    // Sub-block size of the automation ramp, a block that moved the parameters is redesigned this often
+    static constexpr int AutomationSubBlockSize = 64;
 
 
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
@@ -304,13 +517,91 @@ public:
     SingleChannelSampleFifo<BlockType> leftChannelFifo{ Channel::LeftChannel };
     SingleChannelSampleFifo<BlockType> rightChannelFifo{ Channel::RightChannel };
 
+    // The same taps before the filters, only fed while the editor shows the input or the difference
+    SingleChannelSampleFifo<BlockType> inputLeftChannelFifo{ Channel::LeftChannel };
+    SingleChannelSampleFifo<BlockType> inputRightChannelFifo{ Channel::RightChannel };
+    std::atomic<bool> inputTapActive{ false };
+
+    // counts the times the tap was switched on, all four taps restart together then so input and output line up
+    std::atomic<int> inputTapRestarts{ 0 };
+
+    // Levels before and after the filters, only the output has a true peak
+    LevelMeter inputMeter;
+    LevelMeter outputMeter;
+
+    // BS.1770 loudness of the output, always running
+    LoudnessMeter loudnessMeter;
+
+    PerformanceCounters performanceCounters;
+    TraceRecorder traceRecorder;
+
+    SpectrumMatch& getSpectrumMatch() { return *spectrumMatch; }
+
+    // Hands the fitted bands to the extra bands that are bypassed, returns how many were used
+    int applySpectrumMatch();
+
 private:
     //==============================================================================
+    void dumpPerformanceCounters();
+    void dumpTrace();
+
+    // Just the filters, no auto gain estimate, cheap enough to run once per automation sub-block
+    void updateCoefficients(const ChainParameters& chainParameters);
+
+    // the auto gain target and the tail length, see updateFilters()
+    void updateEstimates(const ChainParameters& chainParameters);
+
+    static constexpr double EstimateIntervalSeconds = 0.05;
+    juce::int64 estimateIntervalSamples = 0;
+    juce::int64 samplesSinceEstimates = 0;
+    bool estimatesPending = false;
+
+    void processFilters(const juce::dsp::AudioBlock<float>& block, const juce::dsp::AudioBlock<float>& key);
+
+    bool isRestingAfterSilence(juce::dsp::AudioBlock<float>& block);
+
+    int instanceNumber = 0;
+
+    bool inputTapWasActive = false;
+
+    // processBlock reads every parameter on every block
+    ChainParameterPointers chainParameterPointers{ state };
+
+    //==============================================================================
+
+
+    SectionCascade cascade;
+    SvfCascade svfCascade;
+    SectionList sections;
+
+    // Offline, blocks of at least OfflineMinimumBlockSize have their channels filtered in parallel
+    static constexpr int OfflineMinimumBlockSize = 512;
+    juce::SharedResourcePointer<OfflineRenderPool> offlineRenderPool;
+    DynamicSection dynamicSection;
+
+    // Output gain that undoes the loudness change of the curve, only retargeted with the estimates
+    SectionList loudnessSections;
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> autoGain{ 1.f };
+
+    float getAutoGainTarget(const ChainParameters& chainParameters);
+
+    bool hasDynamicParametric(const ChainParameters& chainParameters) const;
+
+    // Input below SilenceThreshold (-120 dBFS) counts as silence, the tail lasts until the filters
+    // have decayed by TailDecayDecibels. The tail is only retargeted with the estimates.
+    static constexpr float SilenceThreshold = 1.0e-6f;
+    static constexpr double TailDecayDecibels = 120.0;
+
+    SectionList tailSections;
+    juce::int64 tailSamples = 0;
+    std::atomic<double> tailLengthSeconds{ 0.0 };
 
+    juce::int64 silentSamples = 0;
+    bool isResting = false;
 
-    MonoChain left;
+    ChainParameters currentChainParameters;
 
-    MonoChain right;
+    std::unique_ptr<SpectrumMatch> spectrumMatch;
 
     juce::dsp::Oscillator<float> osc;
 
@@ -0,0 +1,281 @@
+/*
+  ==============================================================================
+
+    A runtime sized cascade of biquads kept as a struct of arrays.
+
+    Only the sections in use are stored, so bypassed filters cost nothing,
+    and every channel is run through all sections in the same sample loop
+    with the per channel coefficients and state interleaved next to each
+    other. Sections that only apply to one channel are packed together with
+    the other channel's, the shorter channel is padded with pass through
+    sections. For mid/side the matrix is applied on the way in and out of
+    the same loop, so there is no extra pass over the buffer.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <utility>
+#include <JuceHeader.h>
+#include "SectionDesign.h"
+
+struct SectionCascade
+{
+    static constexpr int MaxChannels = 2;
+
+    void reset()
+    {
+        for (auto* state : { &s1, &s2 })
+            for (auto& section : *state)
+                section.fill(0.f);
+    }
+
+    void setSections(const SectionList& sections, double sampleRate)
+    {
+        std::array<int, MaxChannels> numChannelSections{};
+        std::array<ChannelSlots, MaxSections> newSlots;
+
+        for (int i = 0; i < sections.size; ++i)
+        {
+            auto c = makeDigitalSection(sections.sections[i], sampleRate);
+
+            for (int ch = 0; ch < MaxChannels; ++ch)
+            {
+                if (sections.appliesToChannel(i, ch))
+                {
+                    newSlots[numChannelSections[ch]][ch] = sections.slots[i];
+                    setCoefficients(numChannelSections[ch]++, ch, c);
+                }
+            }
+        }
+
+        auto newNumSections = *std::max_element(numChannelSections.begin(), numChannelSections.end());
+
+        for (int ch = 0; ch < MaxChannels; ++ch)
+        {
+            for (int i = numChannelSections[ch]; i < newNumSections; ++i)
+            {
+                newSlots[i][ch] = NoSlot;
+                setCoefficients(i, ch, {});
+            }
+        }
+
+        moveState(newSlots, newNumSections);
+        numSections = newNumSections;
+
+        // the kernel is picked here, where the section count changes, and not per block
+        stereoKernel = getKernel<2, false>(numSections);
+        midSideKernel = getKernel<2, true>(numSections);
+        monoKernel = getKernel<1, false>(numSections);
+    }
+
+    int getNumSections() const { return numSections; }
+
+    /** One channel on its own with that channel's coefficients, so channels can run on different threads.
+        The state is worked on in a local copy, it sits right next to the other channel's in memory. */
+    void processChannel(float* samples, int numSamples, int channel)
+    {
+        std::array<float, MaxSections> z1, z2;
+
+        for (int i = 0; i < numSections; ++i)
+        {
+            z1[i] = s1[i][channel];
+            z2[i] = s2[i][channel];
+        }
+
+        for (int n = 0; n < numSamples; ++n)
+        {
+            auto x = samples[n];
+
+            for (int i = 0; i < numSections; ++i)
+            {
+                auto y = b0[i][channel] * x + z1[i];
+                z1[i] = b1[i][channel] * x - a1[i][channel] * y + z2[i];
+                z2[i] = b2[i][channel] * x - a2[i][channel] * y;
+                x = y;
+            }
+
+            samples[n] = x;
+        }
+
+        for (int i = 0; i < numSections; ++i)
+        {
+            s1[i][channel] = z1[i];
+            s2[i][channel] = z2[i];
+        }
+    }
+
+    // the mid/side matrix of process() as separate passes, for processChannel
+    static void encodeMidSide(float* left, float* right, int numSamples)
+    {
+        for (int n = 0; n < numSamples; ++n)
+        {
+            auto mid = 0.5f * (left[n] + right[n]);
+            auto side = 0.5f * (left[n] - right[n]);
+            left[n] = mid;
+            right[n] = side;
+        }
+    }
+
+    static void decodeMidSide(float* mid, float* side, int numSamples)
+    {
+        for (int n = 0; n < numSamples; ++n)
+        {
+            auto left = mid[n] + side[n];
+            auto right = mid[n] - side[n];
+            mid[n] = left;
+            side[n] = right;
+        }
+    }
+
+    /** With midSide the first two channels are filtered as (L + R) / 2 and (L - R) / 2. */
+    void process(const juce::dsp::AudioBlock<float>& block, bool midSide = false)
+    {
+        auto numSamples = (int)block.getNumSamples();
+
+        if (block.getNumChannels() >= 2)
+        {
+            std::array<float*, MaxChannels> channels{ block.getChannelPointer(0), block.getChannelPointer(1) };
+
+            (this->*(midSide ? midSideKernel : stereoKernel))(channels, numSamples);
+        }
+        else if (block.getNumChannels() == 1)
+        {
+            (this->*monoKernel)({ block.getChannelPointer(0), nullptr }, numSamples);
+        }
+    }
+
+private:
+    static constexpr int NoSlot = -1;
+
+    using ChannelSlots = std::array<int, MaxChannels>;
+
+    // Every section takes its state along to wherever it is packed now, so switching a band on or off
+    // doesn't hand the state of one filter to another. Sections that were not running start from silence.
+    void moveState(const std::array<ChannelSlots, MaxSections>& newSlots, int newNumSections)
+    {
+        auto oldS1 = s1;
+        auto oldS2 = s2;
+
+        for (int ch = 0; ch < MaxChannels; ++ch)
+        {
+            // the slots keep their order, so the search goes on from the last match
+            int next = 0;
+
+            for (int i = 0; i < newNumSections; ++i)
+            {
+                s1[i][ch] = 0.f;
+                s2[i][ch] = 0.f;
+
+                if (newSlots[i][ch] == NoSlot)
+                    continue;
+
+                for (int j = next; j < numSections; ++j)
+                {
+                    if (slots[j][ch] == newSlots[i][ch])
+                    {
+                        s1[i][ch] = oldS1[j][ch];
+                        s2[i][ch] = oldS2[j][ch];
+                        next = j + 1;
+                        break;
+                    }
+                }
+            }
+        }
+
+        slots = newSlots;
+    }
+
+    void setCoefficients(int index, int channel, const SectionCoefficients& c)
+    {
+        b0[index][channel] = c.b0;
+        b1[index][channel] = c.b1;
+        b2[index][channel] = c.b2;
+        a1[index][channel] = c.a1;
+        a2[index][channel] = c.a2;
+    }
+
+    // Up to this many sections the kernel is compiled for the exact count, so the section loop is
+    // fully unrolled and the state can stay in registers, longer cascades take the runtime loop
+    static constexpr int MaxUnrolledSections = 16;
+    static constexpr int RuntimeSections = -1;
+
+    using Kernel = void (SectionCascade::*)(std::array<float*, MaxChannels>, int);
+
+    template<int NumChannels, bool MidSide, int... Counts>
+    static constexpr std::array<Kernel, sizeof...(Counts)> makeKernelTable(std::integer_sequence<int, Counts...>)
+    {
+        return { &SectionCascade::processChannels<NumChannels, MidSide, Counts>... };
+    }
+
+    template<int NumChannels, bool MidSide>
+    static Kernel getKernel(int count)
+    {
+        static constexpr auto kernels = makeKernelTable<NumChannels, MidSide>(std::make_integer_sequence<int, MaxUnrolledSections + 1>());
+
+        return count <= MaxUnrolledSections ? kernels[(size_t)count]
+                                            : &SectionCascade::processChannels<NumChannels, MidSide, RuntimeSections>;
+    }
+
+    template<int NumChannels, bool MidSide, int FixedSections>
+    void processChannels(std::array<float*, MaxChannels> channels, int numSamples)
+    {
+        static_assert(!MidSide || NumChannels == 2, "mid/side needs two channels");
+
+        const int count = FixedSections == RuntimeSections ? numSections : FixedSections;
+
+        for (int n = 0; n < numSamples; ++n)
+        {
+            float x[NumChannels];
+
+            for (int ch = 0; ch < NumChannels; ++ch)
+                x[ch] = channels[ch][n];
+
+            if constexpr (MidSide)
+            {
+                auto mid = 0.5f * (x[0] + x[1]);
+                auto side = 0.5f * (x[0] - x[1]);
+                x[0] = mid;
+                x[1] = side;
+            }
+
+            // transposed direct form II, the same topology as juce::dsp::IIR::Filter
+            for (int i = 0; i < count; ++i)
+            {
+                for (int ch = 0; ch < NumChannels; ++ch)
+                {
+                    auto y = b0[i][ch] * x[ch] + s1[i][ch];
+                    s1[i][ch] = b1[i][ch] * x[ch] - a1[i][ch] * y + s2[i][ch];
+                    s2[i][ch] = b2[i][ch] * x[ch] - a2[i][ch] * y;
+                    x[ch] = y;
+                }
+            }
+
+            if constexpr (MidSide)
+            {
+                auto left = x[0] + x[1];
+                auto right = x[0] - x[1];
+                x[0] = left;
+                x[1] = right;
+            }
+
+            for (int ch = 0; ch < NumChannels; ++ch)
+                channels[ch][n] = x[ch];
+        }
+    }
+
+    using ChannelValues = std::array<float, MaxChannels>;
+
+    std::array<ChannelValues, MaxSections> b0{}, b1{}, b2{}, a1{}, a2{};
+    std::array<ChannelValues, MaxSections> s1{}, s2{};
+    std::array<ChannelSlots, MaxSections> slots{};
+
+    int numSections = 0;
+
+    Kernel stereoKernel = getKernel<2, false>(0);
+    Kernel midSideKernel = getKernel<2, true>(0);
+    Kernel monoKernel = getKernel<1, false>(0);
+};
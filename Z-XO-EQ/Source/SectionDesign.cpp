@@ -0,0 +1,506 @@
+/*
+  ==============================================================================
+
+    Second order section design.
+
+  ==============================================================================
+*/
+
+#include <complex>
+#include "SectionDesign.h"
+
+namespace
+{
+    using Complex = std::complex<double>;
+
+    constexpr double pi = juce::MathConstants<double>::pi;
+
+    // the cuts are normalised so a single section never peaks above the passband
+    constexpr double chebyshevRippleDecibels = 0.5;
+    constexpr double ellipticRippleDecibels = 0.5;
+    constexpr double ellipticStopbandDecibels = 80.0;
+
+    // Normalised lowpass prototype of one order, kept as the biquad polynomials of each section
+    struct CutPrototype
+    {
+        int numSections = 0;
+        std::array<std::array<double, 3>, MaxCutSections> numerators{};
+        std::array<std::array<double, 3>, MaxCutSections> denominators{};
+
+        void addPolePair(Complex pole, double numeratorConstant)
+        {
+            numerators[numSections] = { 0.0, 0.0, numeratorConstant };
+            denominators[numSections] = { 1.0, -2.0 * pole.real(), std::norm(pole) };
+            ++numSections;
+        }
+    };
+
+    // same pole placement as juce::dsp::FilterDesign's high order Butterworth methods for even orders
+    void designButterworth(CutPrototype& prototype, int order)
+    {
+        for (int i = 0; i < order / 2; ++i)
+        {
+            auto angle = pi * (2.0 * i + 1.0) / (order * 2.0);
+            prototype.addPolePair({ -std::cos(angle), std::sin(angle) }, 1.0);
+        }
+    }
+
+    // two Butterworth filters of half the order, an odd half order leaves a squared real pole
+    void designLinkwitzRiley(CutPrototype& prototype, int order)
+    {
+        auto halfOrder = order / 2;
+
+        for (int i = 0; i < halfOrder / 2; ++i)
+        {
+            // an odd order Butterworth has its real pole at angle 0, the pairs sit pi / halfOrder apart from it
+            auto angle = halfOrder % 2 == 0 ? pi * (2.0 * i + 1.0) / (halfOrder * 2.0)
+                                            : pi * (i + 1.0) / halfOrder;
+            Complex pole{ -std::cos(angle), std::sin(angle) };
+
+            prototype.addPolePair(pole, 1.0);
+            prototype.addPolePair(pole, 1.0);
+        }
+
+        if (halfOrder % 2 == 1)
+            prototype.addPolePair({ -1.0, 0.0 }, 1.0);
+    }
+
+    // Roots of the reverse Bessel polynomial, rescaled so the response is -3 dB at 1
+    void designBessel(CutPrototype& prototype, int order)
+    {
+        std::array<double, 2 * MaxCutSections + 1> coefficients{};
+
+        for (int k = 0; k <= order; ++k)
+        {
+            // (2N - k)! / (2^(N - k) k! (N - k)!)
+            double c = 1.0;
+
+            for (int i = order - k + 1; i <= 2 * order - k; ++i)
+                c *= i;
+
+            for (int i = 2; i <= k; ++i)
+                c /= i;
+
+            coefficients[(size_t)k] = c / std::pow(2.0, order - k);
+        }
+
+        auto evaluate = [&](Complex s)
+        {
+            Complex result = 0.0;
+
+            for (int k = order; k >= 0; --k)
+                result = result * s + coefficients[(size_t)k];
+
+            return result;
+        };
+
+        // Durand-Kerner, the polynomial is monic since the s^N coefficient is 1
+        std::array<Complex, 2 * MaxCutSections> roots;
+        auto radius = std::pow(coefficients[0], 1.0 / order);
+
+        for (int i = 0; i < order; ++i)
+            roots[(size_t)i] = std::polar(radius, 0.4 + 2.0 * pi * i / order);
+
+        for (int iteration = 0; iteration < 500; ++iteration)
+        {
+            double largestStep = 0.0;
+
+            for (int i = 0; i < order; ++i)
+            {
+                Complex denominator = 1.0;
+
+                for (int j = 0; j < order; ++j)
+                    if (j != i)
+                        denominator *= roots[(size_t)i] - roots[(size_t)j];
+
+                auto step = evaluate(roots[(size_t)i]) / denominator;
+                roots[(size_t)i] -= step;
+                largestStep = juce::jmax(largestStep, std::abs(step) / radius);
+            }
+
+            if (largestStep < 1.0e-14)
+                break;
+        }
+
+        auto magnitudeSquared = [&](double omega)
+        {
+            return std::norm(coefficients[0] / evaluate({ 0.0, omega }));
+        };
+
+        double low = 0.0, high = 2.0 * order;
+
+        for (int i = 0; i < 100; ++i)
+        {
+            auto mid = 0.5 * (low + high);
+            (magnitudeSquared(mid) > 0.5 ? low : high) = mid;
+        }
+
+        auto cutoff = 0.5 * (low + high);
+
+        for (int i = 0; i < order; ++i)
+        {
+            auto pole = roots[(size_t)i] / cutoff;
+
+            if (pole.imag() > 0.0)
+                prototype.addPolePair(pole, std::norm(pole));
+        }
+    }
+
+    // Type I, passband ripples between 0 dB and -ripple
+    void designChebyshev(CutPrototype& prototype, int order)
+    {
+        auto epsilon = std::sqrt(std::pow(10.0, chebyshevRippleDecibels / 10.0) - 1.0);
+        auto a = std::asinh(1.0 / epsilon) / order;
+
+        for (int i = 0; i < order / 2; ++i)
+        {
+            auto angle = pi * (2.0 * i + 1.0) / (order * 2.0);
+            Complex pole{ -std::sinh(a) * std::sin(angle), std::cosh(a) * std::cos(angle) };
+            prototype.addPolePair(pole, std::norm(pole));
+        }
+
+        // even orders start at the bottom of a ripple
+        prototype.numerators[0][2] /= std::sqrt(1.0 + epsilon * epsilon);
+    }
+
+    // Elliptic functions through descending Landen transformations, after Orfanidis,
+    // "Lecture Notes on Elliptic Filter Design". u is in units of the quarter period K.
+    constexpr int numLandenSteps = 7;
+
+    std::array<double, numLandenSteps> landen(double k)
+    {
+        std::array<double, numLandenSteps> moduli;
+
+        for (auto& modulus : moduli)
+        {
+            k = std::pow(k / (1.0 + std::sqrt(1.0 - k * k)), 2.0);
+            modulus = k;
+        }
+
+        return moduli;
+    }
+
+    double ellipticK(double k)
+    {
+        double K = pi / 2.0;
+
+        for (auto modulus : landen(k))
+            K *= 1.0 + modulus;
+
+        return K;
+    }
+
+    Complex cde(Complex u, double k)
+    {
+        auto moduli = landen(k);
+        auto w = std::cos(u * pi / 2.0);
+
+        for (int n = numLandenSteps - 1; n >= 0; --n)
+            w = (1.0 + moduli[(size_t)n]) * w / (1.0 + moduli[(size_t)n] * w * w);
+
+        return w;
+    }
+
+    Complex acde(Complex w, double k)
+    {
+        auto moduli = landen(k);
+
+        for (int n = 0; n < numLandenSteps; ++n)
+        {
+            auto previous = n == 0 ? k : moduli[(size_t)n - 1];
+            w = w / (1.0 + std::sqrt(1.0 - w * w * previous * previous)) * 2.0 / (1.0 + moduli[(size_t)n]);
+        }
+
+        return 2.0 / pi * std::acos(w);
+    }
+
+    Complex asne(Complex w, double k) { return 1.0 - acde(w, k); }
+
+    // selectivity that meets the given discrimination with this order
+    double ellipticDegree(int order, double k1)
+    {
+        auto q1 = std::exp(-pi * ellipticK(std::sqrt(1.0 - k1 * k1)) / ellipticK(k1));
+        auto q = std::pow(q1, 1.0 / order);
+
+        double numerator = 0.0, denominator = 0.0;
+
+        for (int m = 1; m <= 7; ++m)
+        {
+            numerator += std::pow(q, m * (m + 1));
+            denominator += std::pow(q, m * m);
+        }
+
+        return 4.0 * std::sqrt(q) * std::pow((1.0 + numerator) / (1.0 + 2.0 * denominator), 2.0);
+    }
+
+    void designElliptic(CutPrototype& prototype, int order)
+    {
+        auto epsilonPass = std::sqrt(std::pow(10.0, ellipticRippleDecibels / 10.0) - 1.0);
+        auto epsilonStop = std::sqrt(std::pow(10.0, ellipticStopbandDecibels / 10.0) - 1.0);
+        auto k1 = epsilonPass / epsilonStop;
+        auto k = ellipticDegree(order, k1);
+
+        const Complex j{ 0.0, 1.0 };
+        auto v0 = -j * asne(j / epsilonPass, k1) / double(order);
+
+        for (int i = 1; i <= order / 2; ++i)
+        {
+            auto u = (2.0 * i - 1.0) / order;
+            auto zero = 1.0 / (k * cde(u, k).real());
+            auto pole = j * cde(u - j * v0, k);
+
+            if (pole.imag() < 0.0)
+                pole = std::conj(pole);
+
+            auto& numerator = prototype.numerators[prototype.numSections];
+            prototype.addPolePair(pole, 1.0);
+
+            // unity at DC before the ripple correction below
+            auto scale = std::norm(pole) / (zero * zero);
+            numerator = { scale, 0.0, scale * zero * zero };
+        }
+
+        prototype.numerators[0][0] /= std::sqrt(1.0 + epsilonPass * epsilonPass);
+        prototype.numerators[0][2] /= std::sqrt(1.0 + epsilonPass * epsilonPass);
+    }
+
+    CutPrototype designCutPrototype(CutResponse response, int order)
+    {
+        CutPrototype prototype;
+
+        switch (response)
+        {
+        case Cut_Butterworth:   designButterworth(prototype, order); break;
+        case Cut_LinkwitzRiley: designLinkwitzRiley(prototype, order); break;
+        case Cut_Bessel:        designBessel(prototype, order); break;
+        case Cut_Chebyshev:     designChebyshev(prototype, order); break;
+        case Cut_Elliptic:      designElliptic(prototype, order); break;
+        }
+
+        return prototype;
+    }
+
+    constexpr int NumCutResponses = Cut_Elliptic + 1;
+
+    // Every prototype is designed the first time any cut is, which happens from prepareToPlay,
+    // so the audio thread only ever copies them
+    const CutPrototype& getCutPrototype(CutResponse response, int order)
+    {
+        using Table = std::array<std::array<CutPrototype, MaxCutSections>, NumCutResponses>;
+
+        static const Table table = []()
+        {
+            Table result;
+
+            for (int r = 0; r < NumCutResponses; ++r)
+                for (int i = 0; i < MaxCutSections; ++i)
+                    result[(size_t)r][(size_t)i] = designCutPrototype((CutResponse)r, 2 * (i + 1));
+
+            return result;
+        }();
+
+        auto index = juce::jlimit(0, MaxCutSections - 1, order / 2 - 1);
+        return table[(size_t)juce::jlimit(0, NumCutResponses - 1, (int)response)][(size_t)index];
+    }
+}
+
+SectionCoefficients makeDigitalSection(const AnalogSection& section, double sampleRate)
+{
+    if (sampleRate <= 0.0)
+        return {};
+
+    auto frequency = juce::jlimit(1.0, sampleRate * 0.499, section.frequency);
+    auto K = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+    auto KK = K * K;
+
+    auto& n = section.numerator;
+    auto& d = section.denominator;
+
+    auto b0 = n[0] + n[1] * K + n[2] * KK;
+    auto b1 = 2.0 * (n[2] * KK - n[0]);
+    auto b2 = n[0] - n[1] * K + n[2] * KK;
+    auto a0 = d[0] + d[1] * K + d[2] * KK;
+    auto a1 = 2.0 * (d[2] * KK - d[0]);
+    auto a2 = d[0] - d[1] * K + d[2] * KK;
+
+    SectionCoefficients c;
+    c.b0 = float(b0 / a0);
+    c.b1 = float(b1 / a0);
+    c.b2 = float(b2 / a0);
+    c.a1 = float(a1 / a0);
+    c.a2 = float(a2 / a0);
+
+    return c;
+}
+
+double getMagnitudeForFrequency(const SectionCoefficients& c, double frequency, double sampleRate)
+{
+    auto omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+    auto z1 = std::polar(1.0, -omega);
+    auto z2 = z1 * z1;
+
+    auto numerator = double(c.b0) + double(c.b1) * z1 + double(c.b2) * z2;
+    auto denominator = 1.0 + double(c.a1) * z1 + double(c.a2) * z2;
+
+    return std::abs(numerator / denominator);
+}
+
+namespace
+{
+    constexpr int NumLoudnessPoints = 64;
+}
+
+double getWeightedPowerGain(const SectionList& sections, int channel, double sampleRate)
+{
+    if (sampleRate <= 0.0)
+        return 1.0;
+
+    std::array<SectionCoefficients, MaxSections> coefficients;
+    int numCoefficients = 0;
+
+    for (int i = 0; i < sections.size; ++i)
+        if (sections.appliesToChannel(i, channel))
+            coefficients[numCoefficients++] = makeDigitalSection(sections.sections[i], sampleRate);
+
+    SectionList weighting;
+    addKWeightingSections(weighting);
+
+    std::array<SectionCoefficients, 2> weightingCoefficients{ makeDigitalSection(weighting.sections[0], sampleRate),
+                                                              makeDigitalSection(weighting.sections[1], sampleRate) };
+
+    double weightedPower = 0.0, totalWeight = 0.0;
+
+    for (int i = 0; i < NumLoudnessPoints; ++i)
+    {
+        auto frequency = juce::mapToLog10((i + 0.5) / NumLoudnessPoints, 20.0, juce::jmin(20000.0, sampleRate * 0.499));
+
+        double weight = 1.0;
+
+        for (const auto& c : weightingCoefficients)
+            weight *= std::pow(getMagnitudeForFrequency(c, frequency, sampleRate), 2.0);
+
+        double magnitude = 1.0;
+
+        for (int c = 0; c < numCoefficients; ++c)
+            magnitude *= getMagnitudeForFrequency(coefficients[c], frequency, sampleRate);
+
+        weightedPower += weight * magnitude * magnitude;
+        totalWeight += weight;
+    }
+
+    return weightedPower / totalWeight;
+}
+
+double getDecaySamples(const SectionList& sections, double sampleRate, double decayDecibels)
+{
+    if (sampleRate <= 0.0)
+        return 0.0;
+
+    auto logDecay = std::log(juce::Decibels::decibelsToGain(-std::abs(decayDecibels), -400.0));
+    double totalSamples = 0.0;
+
+    for (int i = 0; i < sections.size; ++i)
+    {
+        auto c = makeDigitalSection(sections.sections[i], sampleRate);
+
+        double a1 = c.a1, a2 = c.a2;
+        auto discriminant = a1 * a1 - 4.0 * a2;
+
+        auto radius = discriminant < 0.0 ? std::sqrt(a2)
+                                         : 0.5 * (std::abs(a1) + std::sqrt(discriminant));
+
+        // a pole on or outside the unit circle would never decay, count it as very slow instead
+        radius = juce::jmin(radius, 1.0 - 1.0e-7);
+
+        if (radius > 1.0e-9)
+            totalSamples += logDecay / std::log(radius);
+    }
+
+    return totalSamples;
+}
+
+AnalogSection makePeakSection(double frequency, double quality, double gainFactor)
+{
+    auto A = std::sqrt(juce::jmax(0.0, gainFactor));
+
+    return { frequency, { 1.0, A / quality, 1.0 }, { 1.0, 1.0 / (A * quality), 1.0 } };
+}
+
+AnalogSection makeNotchSection(double frequency, double quality)
+{
+    return { frequency, { 1.0, 0.0, 1.0 }, { 1.0, 1.0 / quality, 1.0 } };
+}
+
+AnalogSection makeBandPassSection(double frequency, double quality)
+{
+    return { frequency, { 0.0, 1.0 / quality, 0.0 }, { 1.0, 1.0 / quality, 1.0 } };
+}
+
+// a high shelf of the full gain pulled down by half of it, so the curve pivots around the frequency
+AnalogSection makeTiltSection(double frequency, double quality, double gainFactor)
+{
+    auto A = std::sqrt(juce::jmax(0.0, gainFactor));
+    auto beta = std::sqrt(A) / quality;
+
+    return { frequency, { A, beta, 1.0 }, { 1.0, beta, A } };
+}
+
+// Butterworth style shelf: poles and zeros sit on the same angles, the zeros sqrt(g) further out and
+// the poles sqrt(g) further in with g = gain^(1/order), so the half gain point lands on the frequency.
+// For order 2 this is exactly the RBJ shelf with the same Q.
+void addShelfSections(SectionList& sections, double frequency, double quality, double gainFactor, int order, bool isHighShelf)
+{
+    jassert(order % 2 == 0);
+
+    auto g = std::pow(juce::jmax(1.0e-6, gainFactor), 1.0 / order);
+    auto rootG = std::sqrt(g);
+
+    for (int i = 0; i < order / 2; ++i)
+    {
+        auto damping = 2.0 * std::sin((2.0 * i + 1.0) * juce::MathConstants<double>::pi / (order * 2.0)) / (juce::MathConstants<double>::sqrt2 * quality);
+
+        if (isHighShelf)
+            sections.add({ frequency, { g, damping * rootG, 1.0 }, { 1.0 / g, damping / rootG, 1.0 } });
+        else
+            sections.add({ frequency, { 1.0, damping * rootG, g }, { 1.0, damping / rootG, 1.0 / g } });
+    }
+}
+
+// The analog prototypes behind the standard's 48 kHz coefficients, as libebur128 derives them. The shelf is
+// (Vh s^2 + Vb / Q s + 1) / (s^2 + s / Q + 1), the high pass has the standard's b = { 1, -2, 1 } at 48 kHz,
+// a little above unity gain, so a 1 kHz sine still reads 0.691 dB louder before the loudness offset.
+void addKWeightingSections(SectionList& sections)
+{
+    auto shelfGain = std::pow(10.0, 3.999843853973347 / 20.0);
+    auto shelfMidGain = std::pow(shelfGain, 0.4996667741545416);
+    auto shelfQuality = 0.7071752369554196;
+
+    sections.add({ 1681.974450955533, { shelfGain, shelfMidGain / shelfQuality, 1.0 }, { 1.0, 1.0 / shelfQuality, 1.0 } });
+
+    auto highPassQuality = 0.5003270373238773;
+    auto highPassGain = 1.0 / 0.9950299263000474;
+
+    sections.add({ 38.13547087602444, { highPassGain, 0.0, 0.0 }, { 1.0, 1.0 / highPassQuality, 1.0 } });
+}
+
+// a highpass is the lowpass with s replaced by 1 / s, which reverses both polynomials
+void addCutSections(SectionList& sections, double frequency, int order, CutResponse response, bool isHighPass)
+{
+    jassert(order % 2 == 0);
+
+    const auto& prototype = getCutPrototype(response, order);
+
+    for (int i = 0; i < prototype.numSections; ++i)
+    {
+        auto numerator = prototype.numerators[(size_t)i];
+        auto denominator = prototype.denominators[(size_t)i];
+
+        if (isHighPass)
+        {
+            std::swap(numerator[0], numerator[2]);
+            std::swap(denominator[0], denominator[2]);
+        }
+
+        sections.add({ frequency, numerator, denominator });
+    }
+}
@@ -0,0 +1,126 @@
+/*
+  ==============================================================================
+
+    Second order sections shared by the audio thread and the response curve.
+
+    Every filter in the chain is described once as an analog prototype,
+    H(s) = (n0 s^2 + n1 s + n2) / (d0 s^2 + d1 s + d2) with s normalised to
+    the section frequency, and turned into a biquad with the bilinear
+    transform prewarped at that frequency. For the peak, notch, band pass
+    and Butterworth sections this gives the same coefficients as the
+    juce::dsp::IIR::Coefficients factories.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <JuceHeader.h>
+
+constexpr int MaxBands = 16;
+constexpr int MaxCutSections = 8;
+constexpr int MaxSectionsPerBand = 4;
+constexpr int MaxSections = 2 * MaxCutSections + 1 + MaxBands * MaxSectionsPerBand;
+
+// channel of a section, or every channel
+constexpr int AllChannels = -1;
+
+enum CutResponse
+{
+    Cut_Butterworth,
+    Cut_LinkwitzRiley,
+    Cut_Bessel,
+    Cut_Chebyshev,
+    Cut_Elliptic
+};
+
+struct AnalogSection
+{
+    double frequency{ 1000.0 };
+    std::array<double, 3> numerator{ 0.0, 0.0, 1.0 };
+    std::array<double, 3> denominator{ 0.0, 0.0, 1.0 };
+};
+
+// normalised biquad, a0 == 1
+struct SectionCoefficients
+{
+    float b0{ 1.f };
+    float b1{ 0.f };
+    float b2{ 0.f };
+    float a1{ 0.f };
+    float a2{ 0.f };
+};
+
+struct SectionList
+{
+    void clear() { size = 0; }
+
+    void add(const AnalogSection& section)
+    {
+        jassert(size < MaxSections);
+
+        if (size < MaxSections)
+        {
+            channels[size] = AllChannels;
+            slots[size] = size;
+            sections[size++] = section;
+        }
+    }
+
+    // restricts everything added since firstIndex to one channel
+    void setChannel(int firstIndex, int channel)
+    {
+        for (int i = firstIndex; i < size; ++i)
+            channels[i] = channel;
+    }
+
+    // Marks everything added since firstIndex as the sections of one slot (a cut, a band), so a cascade
+    // knows which running state belongs to which section when slots before it come and go.
+    // Without it a section is known by its index.
+    void setSlot(int firstIndex, int slot)
+    {
+        for (int i = firstIndex; i < size; ++i)
+            slots[i] = slot * MaxSections + i - firstIndex;
+    }
+
+    bool appliesToChannel(int index, int channel) const
+    {
+        return channels[index] == AllChannels || channels[index] == channel;
+    }
+
+    const AnalogSection* begin() const { return sections.data(); }
+    const AnalogSection* end() const { return sections.data() + size; }
+
+    std::array<AnalogSection, MaxSections> sections;
+    std::array<int, MaxSections> channels;
+    std::array<int, MaxSections> slots;
+    int size = 0;
+};
+
+SectionCoefficients makeDigitalSection(const AnalogSection& section, double sampleRate);
+
+double getMagnitudeForFrequency(const SectionCoefficients& coefficients, double frequency, double sampleRate);
+
+// Average power gain of one channel's sections over 20 Hz - 20 kHz on a log frequency grid,
+// K-weighted as in loudness metering so it follows how loud the change sounds rather than how much energy it moves
+double getWeightedPowerGain(const SectionList& sections, int channel, double sampleRate);
+
+// Samples until the impulse response of the sections has decayed by decayDecibels, taken from their pole radii.
+// The tails of a cascade can't outlast the tails of its sections played one after the other, so they are summed.
+double getDecaySamples(const SectionList& sections, double sampleRate, double decayDecibels);
+
+AnalogSection makePeakSection(double frequency, double quality, double gainFactor);
+AnalogSection makeNotchSection(double frequency, double quality);
+AnalogSection makeBandPassSection(double frequency, double quality);
+AnalogSection makeTiltSection(double frequency, double quality, double gainFactor);
+
+// Even orders up to 2 * MaxCutSections. Butterworth and Bessel are -3 dB at the frequency,
+// Linkwitz-Riley -6 dB, Chebyshev and elliptic have their passband edge there.
+void addCutSections(SectionList& sections, double frequency, int order, CutResponse response, bool isHighPass);
+
+// order 2 is the usual RBJ shelf, higher orders steepen the transition around the same midpoint
+void addShelfSections(SectionList& sections, double frequency, double quality, double gainFactor, int order, bool isHighShelf);
+
+// ITU-R BS.1770 K-weighting, the head shelf and the RLB high pass, exact at 48 kHz and prewarped to other rates
+void addKWeightingSections(SectionList& sections);
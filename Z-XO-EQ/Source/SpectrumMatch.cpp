@@ -0,0 +1,285 @@
+/*
+  ==============================================================================
+
+    Spectrum capture and match fitting.
+
+  ==============================================================================
+*/
+
+#include "SpectrumMatch.h"
+
+namespace
+{
+    constexpr int NumFitPoints = 96;
+    constexpr double MinimumBandGain = 0.5;
+    constexpr double MaximumBandGain = 12.0;
+}
+
+SpectrumMatch::SpectrumMatch() : juce::Thread("Spectrum Match")
+{
+    auto fftSize = 1 << Order;
+
+    ring.resize(RingSize);
+    ringTags.resize(RingSize);
+
+    fftDataGenerator.changeOrder(Order);
+    frame.setSize(1, fftSize);
+    fftData.resize((size_t)fftSize * 2);
+
+    referencePower.resize((size_t)fftSize / 2);
+    inputPower.resize((size_t)fftSize / 2);
+}
+
+SpectrumMatch::~SpectrumMatch()
+{
+    stopThread(2000);
+}
+
+void SpectrumMatch::prepare(double sampleRate)
+{
+    const juce::ScopedLock lock(spectrumLock);
+
+    if (sampleRate != spectrumSampleRate)
+    {
+        std::fill(referencePower.begin(), referencePower.end(), 0.0);
+        std::fill(inputPower.begin(), inputPower.end(), 0.0);
+        referenceFrames = inputFrames = 0;
+        spectrumSampleRate = sampleRate;
+    }
+}
+
+void SpectrumMatch::pushSamples(const juce::AudioBuffer<float>& buffer, int numChannels) noexcept
+{
+    numChannels = juce::jmin(numChannels, buffer.getNumChannels());
+
+    auto tag = captureTag.load(std::memory_order_relaxed);
+
+    if ((tag & 3) == CaptureNone || numChannels <= 0)
+        return;
+
+    auto scale = 1.f / (float)numChannels;
+    auto write = ringFifo.write(buffer.getNumSamples());
+
+    auto mixInto = [&](int ringIndex, int numSamples, int bufferIndex)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto sample = 0.f;
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                sample += buffer.getSample(ch, bufferIndex + i);
+
+            ring[(size_t)(ringIndex + i)] = sample * scale;
+        }
+
+        std::fill(ringTags.begin() + ringIndex, ringTags.begin() + ringIndex + numSamples, tag);
+    };
+
+    mixInto(write.startIndex1, write.blockSize1, 0);
+    mixInto(write.startIndex2, write.blockSize2, write.blockSize1);
+}
+
+void SpectrumMatch::setCaptureTarget(CaptureTarget target)
+{
+    captureTarget.store(target);
+    captureTag.store((juce::uint8)((captureTag.load() & ~3) + 4 + target));
+
+    // instances that never capture never start the thread
+    if (target != CaptureNone && !isThreadRunning())
+        startThread();
+
+    notify();
+}
+
+void SpectrumMatch::clear(CaptureTarget target)
+{
+    const juce::ScopedLock lock(spectrumLock);
+
+    if (target == CaptureReference)
+    {
+        std::fill(referencePower.begin(), referencePower.end(), 0.0);
+        referenceFrames = 0;
+    }
+    else if (target == CaptureInput)
+    {
+        std::fill(inputPower.begin(), inputPower.end(), 0.0);
+        inputFrames = 0;
+    }
+}
+
+int SpectrumMatch::getNumFrames(CaptureTarget target) const
+{
+    const juce::ScopedLock lock(spectrumLock);
+
+    return target == CaptureReference ? referenceFrames : target == CaptureInput ? inputFrames : 0;
+}
+
+void SpectrumMatch::run()
+{
+    auto fftSize = frame.getNumSamples();
+    auto hopSize = fftSize / 2;
+    auto* frameData = frame.getWritePointer(0);
+
+    // a frame never mixes two captures, samples queued before a switch stay with the capture they were taken for
+    auto takeSamples = [&](int ringIndex, int numSamples)
+    {
+        for (int i = ringIndex; i < ringIndex + numSamples; ++i)
+        {
+            auto tag = ringTags[(size_t)i];
+
+            if (tag != frameTag)
+            {
+                frameTag = tag;
+                frameFill = 0;
+            }
+
+            frameData[frameFill++] = ring[(size_t)i];
+        }
+    };
+
+    while (!threadShouldExit())
+    {
+        for (;;)
+        {
+            {
+                auto read = ringFifo.read(fftSize - frameFill);
+
+                takeSamples(read.startIndex1, read.blockSize1);
+                takeSamples(read.startIndex2, read.blockSize2);
+            }
+
+            if (frameFill < fftSize)
+                break;
+
+            analyseFrame((CaptureTarget)(frameTag & 3));
+
+            std::copy(frameData + hopSize, frameData + fftSize, frameData);
+            frameFill = hopSize;
+        }
+
+        // asleep until setCaptureTarget() wakes it once nothing is captured and the ring is drained
+        auto idle = captureTarget.load() == CaptureNone && ringFifo.getNumReady() == 0;
+        wait(idle ? -1 : 20);
+    }
+}
+
+void SpectrumMatch::analyseFrame(CaptureTarget target)
+{
+    fftDataGenerator.produceFFTDataForRendering(frame, -160.f);
+
+    while (fftDataGenerator.getFFTData(fftData))
+    {
+        const juce::ScopedLock lock(spectrumLock);
+
+        auto& power = target == CaptureReference ? referencePower : inputPower;
+        auto& numFrames = target == CaptureReference ? referenceFrames : inputFrames;
+
+        for (size_t bin = 0; bin < power.size(); ++bin)
+        {
+            auto magnitude = (double)juce::Decibels::decibelsToGain(fftData[bin], -160.f);
+            power[bin] += magnitude * magnitude;
+        }
+
+        ++numFrames;
+    }
+}
+
+std::vector<SpectrumMatch::FittedBand> SpectrumMatch::fit(int maxBands) const
+{
+    std::array<double, NumFitPoints> frequencies, residual;
+    double sampleRate = 0.0;
+
+    {
+        const juce::ScopedLock lock(spectrumLock);
+
+        if (referenceFrames == 0 || inputFrames == 0 || spectrumSampleRate <= 0.0)
+            return {};
+
+        sampleRate = spectrumSampleRate;
+
+        auto numBins = (int)referencePower.size();
+        auto binWidth = sampleRate / (numBins * 2);
+
+        // third octave smoothing around every point of a log grid
+        for (int i = 0; i < NumFitPoints; ++i)
+        {
+            auto frequency = juce::mapToLog10((i + 0.5) / NumFitPoints, 20.0, juce::jmin(20000.0, sampleRate * 0.45));
+            auto lowBin = juce::jlimit(1, numBins - 1, (int)std::floor(frequency * std::pow(2.0, -1.0 / 6.0) / binWidth));
+            auto highBin = juce::jlimit(lowBin, numBins - 1, (int)std::ceil(frequency * std::pow(2.0, 1.0 / 6.0) / binWidth));
+
+            double reference = 0.0, input = 0.0;
+
+            for (int bin = lowBin; bin <= highBin; ++bin)
+            {
+                reference += referencePower[(size_t)bin];
+                input += inputPower[(size_t)bin];
+            }
+
+            reference /= referenceFrames;
+            input /= inputFrames;
+
+            frequencies[(size_t)i] = frequency;
+            residual[(size_t)i] = 10.0 * std::log10((reference + 1.0e-20) / (input + 1.0e-20));
+        }
+    }
+
+    // only the shape matters, the level is left to the output gain
+    double mean = 0.0;
+    int numInRange = 0;
+
+    for (int i = 0; i < NumFitPoints; ++i)
+    {
+        if (frequencies[(size_t)i] >= 100.0 && frequencies[(size_t)i] <= 10000.0)
+        {
+            mean += residual[(size_t)i];
+            ++numInRange;
+        }
+    }
+
+    if (numInRange > 0)
+        for (auto& r : residual)
+            r -= mean / numInRange;
+
+    // greedy: put a peak on the largest remaining error, as wide as the error is above half its height
+    std::vector<FittedBand> bands;
+
+    for (int b = 0; b < maxBands; ++b)
+    {
+        int peak = 0;
+
+        for (int i = 1; i < NumFitPoints; ++i)
+            if (std::abs(residual[(size_t)i]) > std::abs(residual[(size_t)peak]))
+                peak = i;
+
+        if (std::abs(residual[(size_t)peak]) < MinimumBandGain)
+            break;
+
+        auto gain = juce::jlimit(-MaximumBandGain, MaximumBandGain, residual[(size_t)peak]);
+        auto halfHeight = 0.5 * gain;
+
+        auto low = peak, high = peak;
+
+        while (low > 0 && residual[(size_t)low - 1] * halfHeight > halfHeight * halfHeight)
+            --low;
+
+        while (high < NumFitPoints - 1 && residual[(size_t)high + 1] * halfHeight > halfHeight * halfHeight)
+            ++high;
+
+        auto bandwidth = juce::jmax(1.0 / 3.0, std::log2(frequencies[(size_t)high] / frequencies[(size_t)low]));
+        auto ratio = std::pow(2.0, bandwidth);
+        auto quality = juce::jlimit(0.3, 8.0, std::sqrt(ratio) / (ratio - 1.0));
+
+        FittedBand band;
+        band.frequency = (float)frequencies[(size_t)peak];
+        band.gain = (float)gain;
+        band.quality = (float)quality;
+        bands.push_back(band);
+
+        auto coefficients = makeDigitalSection(makePeakSection(band.frequency, band.quality, juce::Decibels::decibelsToGain((double)band.gain)), sampleRate);
+
+        for (int i = 0; i < NumFitPoints; ++i)
+            residual[(size_t)i] -= juce::Decibels::gainToDecibels(getMagnitudeForFrequency(coefficients, frequencies[(size_t)i], sampleRate));
+    }
+
+    return bands;
+}
@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    Long term average spectra of a reference and of the current input, and a
+    greedy fit of peak bands to the difference between them.
+
+    The audio thread only copies a mono mix into a lock-free ring while a
+    capture is running, every sample tagged with the capture it belongs to.
+    A background thread, started with the first capture and asleep while
+    there is none, cuts it into half overlapping frames for FFTDataGenerator
+    and keeps a running power sum per bin, so a capture can go on for as long
+    as it likes in constant memory.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+class SpectrumMatch : private juce::Thread
+{
+public:
+    enum CaptureTarget
+    {
+        CaptureNone,
+        CaptureReference,
+        CaptureInput
+    };
+
+    struct FittedBand
+    {
+        float frequency = 1000.f;
+        float gain = 0.f;
+        float quality = 1.f;
+    };
+
+    SpectrumMatch();
+    ~SpectrumMatch() override;
+
+    // clears both spectra when the sample rate changes, the bins would no longer line up
+    void prepare(double sampleRate);
+
+    /** Audio thread. Mixes the first numChannels channels down and queues them while capturing. */
+    void pushSamples(const juce::AudioBuffer<float>& buffer, int numChannels) noexcept;
+
+    void setCaptureTarget(CaptureTarget target);
+    CaptureTarget getCaptureTarget() const { return captureTarget.load(); }
+
+    void clear(CaptureTarget target);
+    int getNumFrames(CaptureTarget target) const;
+
+    /** Peak bands that move the input towards the reference, empty until both have been captured. */
+    std::vector<FittedBand> fit(int maxBands) const;
+
+private:
+    static constexpr FFTOrder Order = FFTOrder::order8192;
+    static constexpr int RingSize = 1 << 16;
+
+    void run() override;
+    void analyseFrame(CaptureTarget target);
+
+    std::atomic<CaptureTarget> captureTarget{ CaptureNone };
+
+    // the target in the low two bits, above it a count of setCaptureTarget() calls
+    std::atomic<juce::uint8> captureTag{ CaptureNone };
+
+    // mono samples from the audio thread, a sample with no room left is dropped
+    std::vector<float> ring;
+    std::vector<juce::uint8> ringTags;
+    juce::AbstractFifo ringFifo{ RingSize };
+
+    // background thread only
+    FFTDataGenerator<std::vector<float>> fftDataGenerator;
+    juce::AudioBuffer<float> frame;
+    std::vector<float> fftData;
+    int frameFill = 0;
+    juce::uint8 frameTag = CaptureNone;
+
+    juce::CriticalSection spectrumLock;
+    std::vector<double> referencePower, inputPower;
+    int referenceFrames = 0, inputFrames = 0;
+    double spectrumSampleRate = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumMatch)
+};
@@ -0,0 +1,326 @@
+/*
+  ==============================================================================
+
+    The same cascade as SectionCascade, run as topology preserving state
+    variable filters (Zavalishin, Simper) instead of biquads.
+
+    Every analog section H(s) = (n0 s^2 + n1 s + n2) / (d0 s^2 + d1 s + d2)
+    becomes one SVF with cutoff g = K sqrt(d2 / d0) and damping
+    k = d1 / sqrt(d0 d2), its high, band and low pass outputs mixed by the
+    numerator. K is the prewarp SectionDesign uses for the bilinear
+    transform, so the response is exactly the biquad's. What changes is
+    that the state keeps its meaning while g and k move, so new settings
+    are ramped in sample by sample instead of being swapped in.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <JuceHeader.h>
+#include "SectionDesign.h"
+
+struct SvfCascade
+{
+    static constexpr int MaxChannels = 2;
+    static constexpr int RampLength = 64;
+
+    void reset()
+    {
+        for (auto* state : { &ic1, &ic2 })
+            for (auto& section : *state)
+                section.fill(0.f);
+
+        current = target;
+        rampRemaining = 0;
+        updateMix();
+    }
+
+    /** rampToSections moves the sections that keep running to the new settings over RampLength samples,
+        otherwise they are switched straight away. Sections that come in start from silence at their settings. */
+    void setSections(const SectionList& sections, double sampleRate, bool rampToSections = true)
+    {
+        std::array<int, MaxChannels> numChannelSections{};
+        std::array<ChannelSlots, MaxSections> newSlots;
+
+        for (int i = 0; i < sections.size; ++i)
+        {
+            auto p = makeParameters(sections.sections[i], sampleRate);
+
+            for (int ch = 0; ch < MaxChannels; ++ch)
+            {
+                if (sections.appliesToChannel(i, ch))
+                {
+                    newSlots[(size_t)numChannelSections[ch]][(size_t)ch] = sections.slots[(size_t)i];
+                    target[(size_t)numChannelSections[ch]++][(size_t)ch] = p;
+                }
+            }
+        }
+
+        auto newNumSections = *std::max_element(numChannelSections.begin(), numChannelSections.end());
+
+        for (int ch = 0; ch < MaxChannels; ++ch)
+        {
+            for (int i = numChannelSections[ch]; i < newNumSections; ++i)
+            {
+                newSlots[(size_t)i][(size_t)ch] = NoSlot;
+                target[(size_t)i][(size_t)ch] = {};
+            }
+        }
+
+        moveState(newSlots, newNumSections);
+        numSections = newNumSections;
+
+        if (rampToSections)
+        {
+            auto scale = 1.f / (float)RampLength;
+
+            for (int i = 0; i < newNumSections; ++i)
+            {
+                for (int ch = 0; ch < MaxChannels; ++ch)
+                {
+                    auto& from = current[(size_t)i][(size_t)ch];
+                    auto& to = target[(size_t)i][(size_t)ch];
+                    auto& s = step[(size_t)i][(size_t)ch];
+
+                    s.g = (to.g - from.g) * scale;
+                    s.k = (to.k - from.k) * scale;
+                    s.highPass = (to.highPass - from.highPass) * scale;
+                    s.bandPass = (to.bandPass - from.bandPass) * scale;
+                    s.lowPass = (to.lowPass - from.lowPass) * scale;
+                }
+            }
+
+            rampRemaining = RampLength;
+        }
+        else
+        {
+            current = target;
+            rampRemaining = 0;
+        }
+
+        updateMix();
+    }
+
+    int getNumSections() const { return numSections; }
+
+    /** With midSide the first two channels are filtered as (L + R) / 2 and (L - R) / 2. */
+    void process(const juce::dsp::AudioBlock<float>& block, bool midSide = false)
+    {
+        auto numSamples = (int)block.getNumSamples();
+
+        if (block.getNumChannels() >= 2)
+        {
+            std::array<float*, MaxChannels> channels{ block.getChannelPointer(0), block.getChannelPointer(1) };
+
+            if (midSide)
+                processChannels<2, true>(channels, numSamples);
+            else
+                processChannels<2, false>(channels, numSamples);
+        }
+        else if (block.getNumChannels() == 1)
+        {
+            processChannels<1, false>({ block.getChannelPointer(0), nullptr }, numSamples);
+        }
+    }
+
+private:
+    // the default is a pass through, the three outputs always sum back to the input
+    struct Parameters
+    {
+        float g{ 1.f };
+        float k{ 2.f };
+        float highPass{ 1.f };
+        float bandPass{ 2.f };
+        float lowPass{ 1.f };
+    };
+
+    static constexpr int NoSlot = -1;
+
+    using ChannelSlots = std::array<int, MaxChannels>;
+
+    // As in SectionCascade every section takes its state, and here also the settings it is at, along to
+    // wherever it is packed now. Sections that were not running start from silence at their target.
+    void moveState(const std::array<ChannelSlots, MaxSections>& newSlots, int newNumSections)
+    {
+        auto oldIc1 = ic1;
+        auto oldIc2 = ic2;
+        auto oldCurrent = current;
+
+        for (int ch = 0; ch < MaxChannels; ++ch)
+        {
+            // the slots keep their order, so the search goes on from the last match
+            int next = 0;
+
+            for (int i = 0; i < newNumSections; ++i)
+            {
+                ic1[(size_t)i][(size_t)ch] = 0.f;
+                ic2[(size_t)i][(size_t)ch] = 0.f;
+                current[(size_t)i][(size_t)ch] = target[(size_t)i][(size_t)ch];
+
+                if (newSlots[(size_t)i][(size_t)ch] == NoSlot)
+                    continue;
+
+                for (int j = next; j < numSections; ++j)
+                {
+                    if (slots[(size_t)j][(size_t)ch] == newSlots[(size_t)i][(size_t)ch])
+                    {
+                        ic1[(size_t)i][(size_t)ch] = oldIc1[(size_t)j][(size_t)ch];
+                        ic2[(size_t)i][(size_t)ch] = oldIc2[(size_t)j][(size_t)ch];
+                        current[(size_t)i][(size_t)ch] = oldCurrent[(size_t)j][(size_t)ch];
+                        next = j + 1;
+                        break;
+                    }
+                }
+            }
+        }
+
+        slots = newSlots;
+    }
+
+    static Parameters makeParameters(const AnalogSection& section, double sampleRate)
+    {
+        if (sampleRate <= 0.0)
+            return {};
+
+        auto frequency = juce::jlimit(1.0, sampleRate * 0.499, section.frequency);
+        auto K = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+
+        auto n = section.numerator;
+        auto d = section.denominator;
+
+        // a first order section is run as a second order one with a double pole, one cancelled by the numerator
+        if (d[0] == 0.0)
+        {
+            n = { n[1] * d[1], n[1] * d[2] + n[2] * d[1], n[2] * d[2] };
+            d = { d[1] * d[1], 2.0 * d[1] * d[2], d[2] * d[2] };
+        }
+
+        if (d[0] <= 0.0 || d[2] <= 0.0)
+            return {};
+
+        auto w = std::sqrt(d[2] / d[0]);
+
+        Parameters p;
+        p.g = float(K * w);
+        p.k = float(d[1] / std::sqrt(d[0] * d[2]));
+        p.highPass = float(n[0] / d[0]);
+        p.bandPass = float(n[1] * w / d[2]);
+        p.lowPass = float(n[2] / d[2]);
+
+        return p;
+    }
+
+    // the per sample form of the parameters, with y = m0 x + m1 v1 + m2 v2
+    void updateMix()
+    {
+        for (int i = 0; i < numSections; ++i)
+        {
+            for (int ch = 0; ch < MaxChannels; ++ch)
+            {
+                const auto& p = current[(size_t)i][(size_t)ch];
+
+                auto a = 1.f / (1.f + p.g * (p.g + p.k));
+
+                a1[(size_t)i][(size_t)ch] = a;
+                a2[(size_t)i][(size_t)ch] = p.g * a;
+                a3[(size_t)i][(size_t)ch] = p.g * p.g * a;
+                m0[(size_t)i][(size_t)ch] = p.highPass;
+                m1[(size_t)i][(size_t)ch] = p.bandPass - p.highPass * p.k;
+                m2[(size_t)i][(size_t)ch] = p.lowPass - p.highPass;
+            }
+        }
+    }
+
+    void advanceRamp()
+    {
+        if (--rampRemaining == 0)
+        {
+            current = target;
+        }
+        else
+        {
+            for (int i = 0; i < numSections; ++i)
+            {
+                for (int ch = 0; ch < MaxChannels; ++ch)
+                {
+                    auto& p = current[(size_t)i][(size_t)ch];
+                    const auto& s = step[(size_t)i][(size_t)ch];
+
+                    p.g += s.g;
+                    p.k += s.k;
+                    p.highPass += s.highPass;
+                    p.bandPass += s.bandPass;
+                    p.lowPass += s.lowPass;
+                }
+            }
+        }
+
+        updateMix();
+    }
+
+    template<int NumChannels, bool MidSide>
+    void processChannels(std::array<float*, MaxChannels> channels, int numSamples)
+    {
+        static_assert(!MidSide || NumChannels == 2, "mid/side needs two channels");
+
+        for (int n = 0; n < numSamples; ++n)
+        {
+            if (rampRemaining > 0)
+                advanceRamp();
+
+            float x[NumChannels];
+
+            for (int ch = 0; ch < NumChannels; ++ch)
+                x[ch] = channels[ch][n];
+
+            if constexpr (MidSide)
+            {
+                auto mid = 0.5f * (x[0] + x[1]);
+                auto side = 0.5f * (x[0] - x[1]);
+                x[0] = mid;
+                x[1] = side;
+            }
+
+            for (int i = 0; i < numSections; ++i)
+            {
+                for (int ch = 0; ch < NumChannels; ++ch)
+                {
+                    auto v3 = x[ch] - ic2[i][ch];
+                    auto v1 = a1[i][ch] * ic1[i][ch] + a2[i][ch] * v3;
+                    auto v2 = ic2[i][ch] + a2[i][ch] * ic1[i][ch] + a3[i][ch] * v3;
+
+                    ic1[i][ch] = 2.f * v1 - ic1[i][ch];
+                    ic2[i][ch] = 2.f * v2 - ic2[i][ch];
+
+                    x[ch] = m0[i][ch] * x[ch] + m1[i][ch] * v1 + m2[i][ch] * v2;
+                }
+            }
+
+            if constexpr (MidSide)
+            {
+                auto left = x[0] + x[1];
+                auto right = x[0] - x[1];
+                x[0] = left;
+                x[1] = right;
+            }
+
+            for (int ch = 0; ch < NumChannels; ++ch)
+                channels[ch][n] = x[ch];
+        }
+    }
+
+    using ChannelValues = std::array<float, MaxChannels>;
+    using ChannelParameters = std::array<Parameters, MaxChannels>;
+
+    std::array<ChannelParameters, MaxSections> current{}, target{}, step{};
+    std::array<ChannelValues, MaxSections> a1{}, a2{}, a3{}, m0{}, m1{}, m2{};
+    std::array<ChannelValues, MaxSections> ic1{}, ic2{};
+    std::array<ChannelSlots, MaxSections> slots{};
+
+    int numSections = 0;
+    int rampRemaining = 0;
+};
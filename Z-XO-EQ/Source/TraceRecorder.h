@@ -0,0 +1,213 @@
+/*
+  ==============================================================================
+
+    Optional span tracing, exported in the Chrome / Perfetto trace event
+    JSON format. Each thread writes into its own lock-free ring so the audio
+    thread never waits on the message thread. A timer on the message thread
+    empties the rings into a list that grows until the trace is written, so
+    long sessions aren't cut short by the ring size.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <vector>
+#include <JuceHeader.h>
+
+struct TraceRecorder : private juce::Timer
+{
+    enum TraceThread
+    {
+        AudioThread,
+        MessageThread,
+        NumTraceThreads
+    };
+
+    struct Event
+    {
+        const char* name = nullptr; // must point at a string literal
+        juce::int64 startTicks = 0;
+        juce::int64 endTicks = 0;
+    };
+
+    // beyond this many events per thread between two writes, events are dropped and counted
+    static constexpr int MaxCollectedEvents = 1 << 20;
+
+    ~TraceRecorder() override { stopTimer(); }
+
+    /** Message thread only. */
+    void setEnabled(bool shouldBeEnabled)
+    {
+        if (shouldBeEnabled)
+            for (auto& ring : rings)
+                ring.prepare();
+
+        enabled.store(shouldBeEnabled);
+
+        if (shouldBeEnabled)
+            startTimer(DrainIntervalMs);
+        else
+            stopTimer();
+    }
+
+    bool isEnabled() const noexcept { return enabled.load(std::memory_order_relaxed); }
+
+    void addEvent(TraceThread thread, const char* name, juce::int64 startTicks, juce::int64 endTicks) noexcept
+    {
+        rings[thread].push({ name, startTicks, endTicks });
+    }
+
+    /** Drains every ring and writes the events collected since the last write as a Chrome trace. */
+    bool writeChromeTrace(const juce::File& file, int processId)
+    {
+        static const char* threadNames[] = { "Audio", "Message" };
+
+        const juce::ScopedLock sl(collectedLock);
+        drainRings();
+
+        juce::String json;
+        json << "{\"traceEvents\":[\n";
+
+        bool first = true;
+        auto addSeparator = [&json, &first]()
+        {
+            if (!first)
+                json << ",\n";
+            first = false;
+        };
+
+        for (int t = 0; t < NumTraceThreads; ++t)
+        {
+            addSeparator();
+            json << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << processId << ",\"tid\":" << t
+                 << ",\"args\":{\"name\":\"" << threadNames[t] << "\"}}";
+
+            for (auto& e : collected[(size_t)t])
+            {
+                addSeparator();
+                json << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":" << processId << ",\"tid\":" << t
+                     << ",\"ts\":" << ticksToMicroseconds(e.startTicks - originTicks)
+                     << ",\"dur\":" << ticksToMicroseconds(e.endTicks - e.startTicks) << "}";
+            }
+
+            // a full ring drops on the writing thread, a full list here, both since tracing started
+            if (auto dropped = rings[t].getNumDropped() + numDroppedCollecting[(size_t)t]; dropped > 0)
+            {
+                addSeparator();
+                json << "{\"name\":\"dropped events\",\"ph\":\"C\",\"pid\":" << processId << ",\"tid\":" << t
+                     << ",\"ts\":0,\"args\":{\"count\":" << dropped << "}}";
+            }
+
+            collected[(size_t)t].clear();
+        }
+
+        json << "\n]}\n";
+
+        return file.replaceWithText(json);
+    }
+
+private:
+    static constexpr int DrainIntervalMs = 100;
+
+    void timerCallback() override
+    {
+        const juce::ScopedLock sl(collectedLock);
+        drainRings();
+    }
+
+    void drainRings()
+    {
+        for (int t = 0; t < NumTraceThreads; ++t)
+        {
+            auto& events = collected[(size_t)t];
+
+            Event e;
+            while (rings[t].pull(e))
+            {
+                if ((int)events.size() < MaxCollectedEvents)
+                    events.push_back(e);
+                else
+                    ++numDroppedCollecting[(size_t)t];
+            }
+        }
+    }
+
+    struct Ring
+    {
+        static constexpr int Capacity = 1 << 15;
+
+        void prepare()
+        {
+            if (events.empty())
+                events.resize(Capacity);
+        }
+
+        void push(const Event& e) noexcept
+        {
+            auto write = fifo.write(1);
+
+            if (write.blockSize1 > 0)
+                events[(size_t)write.startIndex1] = e;
+            else
+                numDropped.store(numDropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        bool pull(Event& e) noexcept
+        {
+            auto read = fifo.read(1);
+
+            if (read.blockSize1 > 0)
+            {
+                e = events[(size_t)read.startIndex1];
+                return true;
+            }
+
+            return false;
+        }
+
+        juce::int64 getNumDropped() const noexcept { return numDropped.load(std::memory_order_relaxed); }
+
+        std::vector<Event> events;
+        juce::AbstractFifo fifo{ Capacity };
+        std::atomic<juce::int64> numDropped{ 0 };
+    };
+
+    static double ticksToMicroseconds(juce::int64 ticks)
+    {
+        return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e6;
+    }
+
+    std::atomic<bool> enabled{ false };
+    juce::int64 originTicks = juce::Time::getHighResolutionTicks();
+    std::array<Ring, NumTraceThreads> rings;
+
+    juce::CriticalSection collectedLock;
+    std::array<std::vector<Event>, NumTraceThreads> collected;
+    std::array<juce::int64, NumTraceThreads> numDroppedCollecting{};
+};
+
+/** Records one span on the given thread's ring, costs a single relaxed load when tracing is off. */
+struct ScopedTraceSpan
+{
+    ScopedTraceSpan(TraceRecorder& r, TraceRecorder::TraceThread t, const char* spanName) noexcept
+        : recorder(r), thread(t), name(spanName)
+    {
+        if (recorder.isEnabled())
+            startTicks = juce::Time::getHighResolutionTicks();
+    }
+
+    ~ScopedTraceSpan()
+    {
+        if (startTicks != 0)
+            recorder.addEvent(thread, name, startTicks, juce::Time::getHighResolutionTicks());
+    }
+
+private:
+    TraceRecorder& recorder;
+    TraceRecorder::TraceThread thread;
+    const char* name;
+    juce::int64 startTicks = 0;
+};
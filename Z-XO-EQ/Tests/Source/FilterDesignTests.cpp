@@ -0,0 +1,457 @@
+/*
+  ==============================================================================
+
+    Checks the filter path against references that don't share its code.
+
+    The analog cut prototypes are compared with the textbook magnitude of
+    each response, the biquads with their analog prototype at the prewarped
+    frequency, and the cascades with a plain double precision direct form
+    run of the same coefficients.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <complex>
+#include <vector>
+#include "../../Source/SectionDesign.h"
+#include "../../Source/SectionCascade.h"
+#include "../../Source/SvfCascade.h"
+
+namespace
+{
+    constexpr double testSampleRate = 48000.0;
+    constexpr double testFrequency = 1000.0;
+
+    // single precision through tens of sections, a 40 Hz elliptic among them
+    constexpr double cascadeTolerance = 5.0e-4;
+    constexpr double svfTolerance = 2.0e-3;
+
+    const juce::StringArray responseNames{ "Butterworth", "Linkwitz-Riley", "Bessel", "Chebyshev", "Elliptic" };
+
+    // w is relative to the section frequency
+    double getAnalogMagnitude(const AnalogSection& section, double w)
+    {
+        std::complex<double> s{ 0.0, w };
+
+        auto& n = section.numerator;
+        auto& d = section.denominator;
+
+        return std::abs((n[0] * s * s + n[1] * s + n[2]) / (d[0] * s * s + d[1] * s + d[2]));
+    }
+
+    double getAnalogDecibels(const SectionList& sections, double w)
+    {
+        double magnitude = 1.0;
+
+        for (auto& section : sections)
+            magnitude *= getAnalogMagnitude(section, w);
+
+        return juce::Decibels::gainToDecibels(magnitude, -400.0);
+    }
+
+    double getDigitalDecibels(const SectionList& sections, double frequency)
+    {
+        double magnitude = 1.0;
+
+        for (auto& section : sections)
+            magnitude *= getMagnitudeForFrequency(makeDigitalSection(section, testSampleRate), frequency, testSampleRate);
+
+        return juce::Decibels::gainToDecibels(magnitude, -400.0);
+    }
+
+    double chebyshevPolynomial(int order, double w)
+    {
+        return w <= 1.0 ? std::cos(order * std::acos(w)) : std::cosh(order * std::acosh(w));
+    }
+
+    // the closed form lowpass magnitude where the response has one, NaN otherwise
+    double getReferenceDecibels(CutResponse response, int order, double w)
+    {
+        switch (response)
+        {
+        case Cut_Butterworth:
+            return -10.0 * std::log10(1.0 + std::pow(w, 2.0 * order));
+
+        case Cut_Chebyshev:
+        {
+            auto epsilonSquared = std::pow(10.0, 0.05) - 1.0;
+            return -10.0 * std::log10(1.0 + epsilonSquared * std::pow(chebyshevPolynomial(order, w), 2.0));
+        }
+
+        // the square of a Butterworth of half the order
+        case Cut_LinkwitzRiley:
+            return -20.0 * std::log10(1.0 + std::pow(w, (double)order));
+
+        default:
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+    }
+
+    // direct form I in doubles, one channel through the sections that apply to it
+    std::vector<double> runReference(const SectionList& sections, int channel, std::vector<double> samples)
+    {
+        for (int i = 0; i < sections.size; ++i)
+        {
+            if (!sections.appliesToChannel(i, channel))
+                continue;
+
+            auto c = makeDigitalSection(sections.sections[i], testSampleRate);
+            double x1 = 0.0, x2 = 0.0, y1 = 0.0, y2 = 0.0;
+
+            for (auto& sample : samples)
+            {
+                auto y = c.b0 * sample + c.b1 * x1 + c.b2 * x2 - c.a1 * y1 - c.a2 * y2;
+
+                x2 = x1;
+                x1 = sample;
+                y2 = y1;
+                y1 = y;
+                sample = y;
+            }
+        }
+
+        return samples;
+    }
+
+    std::vector<double> makeTestSignal(int numSamples, int seed)
+    {
+        juce::Random random(seed);
+        std::vector<double> samples((size_t)numSamples);
+
+        samples[0] = 1.0;
+
+        for (int i = 1; i < numSamples; ++i)
+            samples[(size_t)i] = 0.5 * std::sin(0.013 * i * (seed + 1)) + 0.25 * (random.nextDouble() - 0.5);
+
+        return samples;
+    }
+
+    // every kind of section, some on one channel only
+    SectionList makeMixedSections(int numPeaks)
+    {
+        SectionList sections;
+        addCutSections(sections, 40.0, 8, Cut_Elliptic, true);
+
+        for (int i = 0; i < numPeaks; ++i)
+            sections.add(makePeakSection(100.0 * (i + 1), 2.0, i % 2 == 0 ? 2.0 : 0.5));
+
+        auto firstSection = sections.size;
+        sections.add(makeNotchSection(3000.0, 5.0));
+        sections.setChannel(firstSection, 1);
+
+        sections.add(makeBandPassSection(5000.0, 0.5));
+        sections.add(makeTiltSection(800.0, 0.7, 2.0));
+        addShelfSections(sections, 200.0, 0.7, 0.5, 4, false);
+
+        addCutSections(sections, 12000.0, 6, Cut_Bessel, false);
+        return sections;
+    }
+
+    // A cut, a shelf and a cut on slots 0, 2 and 3. The band on slot 1 between them is a peak at 0 dB: running
+    // from silence it passes its input exactly, so switching it on or off must leave the output as it was.
+    SectionList makeSlottedSections(bool withMiddleBand, int middleBandChannel)
+    {
+        SectionList sections;
+        addCutSections(sections, 40.0, 4, Cut_Butterworth, true);
+        sections.setSlot(0, 0);
+
+        if (withMiddleBand)
+        {
+            auto firstSection = sections.size;
+            sections.add(makePeakSection(1000.0, 1.0, 1.0));
+            sections.setSlot(firstSection, 1);
+
+            if (middleBandChannel != AllChannels)
+                sections.setChannel(firstSection, middleBandChannel);
+        }
+
+        auto firstSection = sections.size;
+        addShelfSections(sections, 3000.0, 0.7, 2.0, 4, true);
+        sections.setSlot(firstSection, 2);
+
+        firstSection = sections.size;
+        addCutSections(sections, 8000.0, 4, Cut_Butterworth, false);
+        sections.setSlot(firstSection, 3);
+        return sections;
+    }
+}
+
+//==============================================================================
+struct CutPrototypeTests : juce::UnitTest
+{
+    CutPrototypeTests() : juce::UnitTest("Cut prototypes", "Z-XO-EQ") {}
+
+    void runTest() override
+    {
+        for (int response = Cut_Butterworth; response <= Cut_Elliptic; ++response)
+        {
+            beginTest(responseNames[response]);
+
+            for (int order = 2; order <= 2 * MaxCutSections; order += 2)
+            {
+                SectionList lowPass, highPass;
+                addCutSections(lowPass, testFrequency, order, (CutResponse)response, false);
+                addCutSections(highPass, testFrequency, order, (CutResponse)response, true);
+
+                auto describe = [&](double w) { return responseNames[response] + " order " + juce::String(order) + " at " + juce::String(w) + " fc"; };
+
+                for (double w = 0.05; w < 20.0; w *= 1.1)
+                {
+                    auto decibels = getAnalogDecibels(lowPass, w);
+                    auto reference = getReferenceDecibels((CutResponse)response, order, w);
+
+                    if (!std::isnan(reference) && reference > -120.0)
+                        expectWithinAbsoluteError(decibels, reference, 0.01, describe(w));
+
+                    // a highpass is the lowpass mirrored around the cut frequency
+                    expectWithinAbsoluteError(getAnalogDecibels(highPass, 1.0 / w), decibels, 1.0e-6, "highpass " + describe(w));
+                }
+
+                if (response == Cut_Bessel)
+                    expectWithinAbsoluteError(getAnalogDecibels(lowPass, 1.0), -3.0103, 0.01, describe(1.0));
+
+                if (response == Cut_Chebyshev || response == Cut_Elliptic)
+                {
+                    for (double w = 0.01; w <= 1.0; w += 0.01)
+                    {
+                        auto decibels = getAnalogDecibels(lowPass, w);
+                        expect(decibels <= 1.0e-6 && decibels >= -0.5 - 1.0e-6, "passband ripple " + describe(w));
+                    }
+
+                    expectWithinAbsoluteError(getAnalogDecibels(lowPass, 1.0), -0.5, 0.01, describe(1.0));
+                }
+
+                if (response == Cut_Elliptic)
+                    expect(getAnalogDecibels(lowPass, 1000.0) <= -79.99, "stopband " + describe(1000.0));
+            }
+        }
+    }
+};
+
+//==============================================================================
+struct DigitalSectionTests : juce::UnitTest
+{
+    DigitalSectionTests() : juce::UnitTest("Digital sections", "Z-XO-EQ") {}
+
+    void runTest() override
+    {
+        // the bilinear transform maps f to the analog prototype at tan(pi f / fs) / tan(pi fc / fs)
+        auto warp = [](double frequency, double sectionFrequency)
+        {
+            auto pi = juce::MathConstants<double>::pi;
+            return std::tan(pi * frequency / testSampleRate) / std::tan(pi * sectionFrequency / testSampleRate);
+        };
+
+        beginTest("Cuts at every slope");
+
+        for (int response = Cut_Butterworth; response <= Cut_Elliptic; ++response)
+        {
+            for (int order = 2; order <= 2 * MaxCutSections; order += 2)
+            {
+                for (auto isHighPass : { false, true })
+                {
+                    SectionList sections;
+                    addCutSections(sections, testFrequency, order, (CutResponse)response, isHighPass);
+
+                    for (double frequency = 20.0; frequency < 20000.0; frequency *= 1.15)
+                    {
+                        auto analog = getAnalogDecibels(sections, warp(frequency, testFrequency));
+
+                        // single precision coefficients only hold so far into the stopband
+                        if (analog > -60.0)
+                            expectWithinAbsoluteError(getDigitalDecibels(sections, frequency), analog, 0.05,
+                                responseNames[response] + " order " + juce::String(order) + (isHighPass ? " highpass" : " lowpass")
+                                    + " at " + juce::String(frequency) + " Hz");
+                    }
+                }
+            }
+        }
+
+        beginTest("Bands");
+
+        SectionList bands;
+        bands.add(makePeakSection(testFrequency, 2.0, 4.0));
+        bands.add(makeNotchSection(testFrequency, 5.0));
+        bands.add(makeBandPassSection(testFrequency, 1.0));
+        bands.add(makeTiltSection(testFrequency, 0.7, 2.0));
+        addShelfSections(bands, testFrequency, 0.7, 4.0, 2, false);
+        addShelfSections(bands, testFrequency, 0.7, 0.25, 6, true);
+
+        for (auto& section : bands)
+        {
+            SectionList single;
+            single.add(section);
+
+            for (double frequency = 20.0; frequency < 20000.0; frequency *= 1.15)
+            {
+                auto analog = getAnalogDecibels(single, warp(frequency, section.frequency));
+
+                if (analog > -60.0)
+                    expectWithinAbsoluteError(getDigitalDecibels(single, frequency), analog, 0.05);
+            }
+        }
+
+        beginTest("Peak gain at its frequency");
+
+        SectionList peak;
+        peak.add(makePeakSection(testFrequency, 2.0, juce::Decibels::decibelsToGain(6.0)));
+        expectWithinAbsoluteError(getDigitalDecibels(peak, testFrequency), 6.0, 0.01);
+
+        beginTest("Weighted power gain");
+
+        expectWithinAbsoluteError(getWeightedPowerGain({}, 0, testSampleRate), 1.0, 1.0e-9);
+
+        // a shelf far above the audio band is a plain gain over all of it
+        SectionList shelf;
+        addShelfSections(shelf, 200000.0, 0.7, 0.5, 2, false);
+        expectWithinAbsoluteError(getWeightedPowerGain(shelf, 0, 192000.0), 0.25, 1.0e-3);
+
+        // a boost on the other channel leaves this one alone
+        auto firstSection = peak.size;
+        peak.add(makePeakSection(testFrequency, 0.5, 4.0));
+        peak.setChannel(firstSection, 1);
+
+        auto power = getWeightedPowerGain(peak, 0, testSampleRate);
+        expect(power > 1.0 && power < juce::Decibels::decibelsToGain(12.0));
+        expect(getWeightedPowerGain(peak, 1, testSampleRate) > power);
+    }
+};
+
+//==============================================================================
+struct CascadeTests : juce::UnitTest
+{
+    CascadeTests() : juce::UnitTest("Cascades", "Z-XO-EQ") {}
+
+    // the band is switched every block, and the cascade has to run as if it had never been there
+    template <typename Cascade>
+    void checkSwitchingMiddleBand(const std::vector<double>& left, const std::vector<double>& right, int middleBandChannel, const juce::String& name)
+    {
+        constexpr int blockSize = 512;
+
+        auto numSamples = (int)left.size();
+
+        std::vector<float> l(left.begin(), left.end()), r(right.begin(), right.end());
+        std::vector<float> expectedL(l), expectedR(r);
+
+        Cascade cascade, expected;
+        expected.setSections(makeSlottedSections(false, middleBandChannel), testSampleRate);
+
+        for (int start = 0; start + blockSize <= numSamples; start += blockSize)
+        {
+            cascade.setSections(makeSlottedSections((start / blockSize) % 2 == 0, middleBandChannel), testSampleRate);
+
+            float* channels[] = { l.data() + start, r.data() + start };
+            cascade.process(juce::dsp::AudioBlock<float>(channels, 2, (size_t)blockSize));
+
+            float* expectedChannels[] = { expectedL.data() + start, expectedR.data() + start };
+            expected.process(juce::dsp::AudioBlock<float>(expectedChannels, 2, (size_t)blockSize));
+        }
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            expectWithinAbsoluteError(l[(size_t)i], expectedL[(size_t)i], 1.0e-6f, name + "left sample " + juce::String(i));
+            expectWithinAbsoluteError(r[(size_t)i], expectedR[(size_t)i], 1.0e-6f, name + "right sample " + juce::String(i));
+        }
+    }
+
+    void runTest() override
+    {
+        constexpr int numSamples = 4096;
+
+        auto left = makeTestSignal(numSamples, 1);
+        auto right = makeTestSignal(numSamples, 2);
+
+        for (auto middleBandChannel : { AllChannels, 0 })
+        {
+            beginTest("Switching a middle band " + juce::String(middleBandChannel == AllChannels ? "on both channels" : "on one channel"));
+
+            checkSwitchingMiddleBand<SectionCascade>(left, right, middleBandChannel, "biquad ");
+            checkSwitchingMiddleBand<SvfCascade>(left, right, middleBandChannel, "svf ");
+        }
+
+        // either side of the longest unrolled kernel, and every section the cascade has room for
+        for (auto numPeaks : { 0, 4, 5, MaxSections - 12 })
+        {
+            auto sections = makeMixedSections(numPeaks);
+
+            beginTest(juce::String(sections.size) + " sections");
+
+            auto expectedLeft = runReference(sections, 0, left);
+            auto expectedRight = runReference(sections, 1, right);
+
+            std::vector<float> l(left.begin(), left.end()), r(right.begin(), right.end());
+            float* channels[] = { l.data(), r.data() };
+
+            SectionCascade cascade;
+            cascade.setSections(sections, testSampleRate);
+            cascade.process(juce::dsp::AudioBlock<float>(channels, 2, (size_t)numSamples));
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                expectWithinAbsoluteError((double)l[(size_t)i], expectedLeft[(size_t)i], cascadeTolerance);
+                expectWithinAbsoluteError((double)r[(size_t)i], expectedRight[(size_t)i], cascadeTolerance);
+            }
+
+            // the state variable filters compute a different but equivalent recursion
+            {
+                std::vector<float> svfLeft(left.begin(), left.end()), svfRight(right.begin(), right.end());
+                float* svfChannels[] = { svfLeft.data(), svfRight.data() };
+
+                SvfCascade svf;
+                svf.setSections(sections, testSampleRate, false);
+                svf.process(juce::dsp::AudioBlock<float>(svfChannels, 2, (size_t)numSamples));
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    expectWithinAbsoluteError((double)svfLeft[(size_t)i], expectedLeft[(size_t)i], svfTolerance);
+                    expectWithinAbsoluteError((double)svfRight[(size_t)i], expectedRight[(size_t)i], svfTolerance);
+                }
+            }
+
+            // a single channel has to give what it gives next to the other one
+            {
+                std::vector<float> alone(left.begin(), left.end());
+                float* channel[] = { alone.data() };
+
+                SectionCascade single;
+                single.setSections(sections, testSampleRate);
+                single.process(juce::dsp::AudioBlock<float>(channel, 1, (size_t)numSamples));
+
+                for (int i = 0; i < numSamples; ++i)
+                    expectWithinAbsoluteError(alone[(size_t)i], l[(size_t)i], 1.0e-6f);
+            }
+
+            // mid/side is the same filtering on (L + R) / 2 and (L - R) / 2
+            {
+                std::vector<double> mid((size_t)numSamples), side((size_t)numSamples);
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    mid[(size_t)i] = 0.5 * (left[(size_t)i] + right[(size_t)i]);
+                    side[(size_t)i] = 0.5 * (left[(size_t)i] - right[(size_t)i]);
+                }
+
+                mid = runReference(sections, 0, mid);
+                side = runReference(sections, 1, side);
+
+                std::vector<float> ml(left.begin(), left.end()), mr(right.begin(), right.end());
+                float* midSideChannels[] = { ml.data(), mr.data() };
+
+                SectionCascade midSideCascade;
+                midSideCascade.setSections(sections, testSampleRate);
+                midSideCascade.process(juce::dsp::AudioBlock<float>(midSideChannels, 2, (size_t)numSamples), true);
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    expectWithinAbsoluteError((double)ml[(size_t)i], mid[(size_t)i] + side[(size_t)i], cascadeTolerance);
+                    expectWithinAbsoluteError((double)mr[(size_t)i], mid[(size_t)i] - side[(size_t)i], cascadeTolerance);
+                }
+            }
+        }
+    }
+};
+
+static CutPrototypeTests cutPrototypeTests;
+static DigitalSectionTests digitalSectionTests;
+static CascadeTests cascadeTests;
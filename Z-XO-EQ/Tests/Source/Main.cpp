@@ -0,0 +1,45 @@
+/*
+  ==============================================================================
+
+    Runs the plugin's unit tests, the exit code is the number of failures.
+
+      Z-XO-EQ-Tests [--tolerance=value] [--golden=directory] [--update-golden]
+
+    The processor tests compare their output with the files in Tests/Golden.
+    --tolerance sets the largest difference a sample may have (1e-4 unless
+    given), --golden reads the files from another directory, and
+    --update-golden rewrites the ones this build no longer matches instead
+    of failing.
+
+  ==============================================================================
+*/
+
+#include "TestOptions.h"
+
+int main(int argc, char* argv[])
+{
+    juce::ArgumentList arguments(argc, argv);
+    auto& options = getTestOptions();
+
+    if (arguments.containsOption("--tolerance"))
+        options.tolerance = arguments.getValueForOption("--tolerance").getDoubleValue();
+
+    if (arguments.containsOption("--golden"))
+        options.goldenDirectory = arguments.getFileForOption("--golden");
+
+    options.updateGolden = arguments.containsOption("--update-golden");
+
+    // the processor's parameters need the message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+    runner.runTestsInCategory("Z-XO-EQ");
+
+    int failures = 0;
+
+    for (int i = 0; i < runner.getNumResults(); ++i)
+        failures += runner.getResult(i)->failures;
+
+    return juce::jmin(failures, 255);
+}
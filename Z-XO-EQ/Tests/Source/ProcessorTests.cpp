@@ -0,0 +1,760 @@
+/*
+  ==============================================================================
+
+    Renders test signals through ZXOEQAudioProcessor::processBlock and
+    compares the output with the buffers in Tests/Golden.
+
+    An impulse, a logarithmic sweep and noise are rendered at 48 kHz in
+    blocks of uneven size, for every cut slope at three frequency settings,
+    for every bypass combination, for each cut response, with auto gain, for
+    each type of the extra bands, with the parametric band dynamic, keyed
+    from its input and from the sidechain, in every processing mode with
+    bands on one channel, and with parameters that change between blocks,
+    stepped and ramped, and with the state variable filter engine. A golden
+    file is the stereo output of one case and signal, as planar little
+    endian 32 bit floats.
+
+    The response curve the editor draws is checked against the response
+    measured from an impulse through processBlock, up to the auto gain, and
+    sound that follows a skipped silence against a processor that was
+    silent all along, and offline renders, which filter the channels on a
+    thread pool, against realtime ones.
+
+  ==============================================================================
+*/
+
+#include <complex>
+#include <map>
+#include "TestOptions.h"
+#include "../../Source/PluginProcessor.h"
+
+namespace
+{
+    constexpr double testSampleRate = 48000.0;
+    constexpr int maximumBlockSize = 512;
+    constexpr int numSamples = 1024;
+    constexpr int numSlopes = Slope_96dB + 1;
+
+    // uneven on purpose, one of them far smaller than the rest
+    const int blockSizes[] = { 256, 300, 7, 461 };
+
+    using Settings = std::vector<std::pair<juce::String, float>>;
+
+    struct GoldenCase
+    {
+        juce::String name;
+        Settings settings;
+
+        // set before the block with the same index
+        std::map<int, Settings> automation;
+
+        // the sidechain bus is enabled and fed with the key signal
+        bool sidechain = false;
+    };
+
+    struct FrequencySetting
+    {
+        juce::String name;
+        float lowCut, parametric, gain, quality, highCut;
+    };
+
+    const FrequencySetting frequencySettings[] = {
+        { "low", 30.f, 120.f, 9.f, 0.7f, 1500.f },
+        { "mid", 120.f, 1000.f, -6.f, 2.f, 8000.f },
+        { "high", 600.f, 6000.f, 4.5f, 5.f, 18000.f },
+    };
+
+    enum Signal
+    {
+        Signal_Impulse,
+        Signal_Sweep,
+        Signal_Noise,
+        NumSignals
+    };
+
+    const juce::StringArray signalNames{ "impulse", "sweep", "noise" };
+
+    juce::String getSlopeName(int slope)
+    {
+        return juce::String(12 * (slope + 1)) + "dB";
+    }
+
+    // every parameter the audio path reads, so that a changed default can't change a case
+    Settings getSettings(const FrequencySetting& frequencies, int slope)
+    {
+        Settings settings{
+            { "LowCut Frequency", frequencies.lowCut },
+            { "LowCut Slope", (float)slope },
+            { "LowCut Response", (float)Cut_Butterworth },
+            { "LowCut Bypass", 0.f },
+            { "Parametric Frequency", frequencies.parametric },
+            { "Parametric Gain", frequencies.gain },
+            { "Parametric Quality", frequencies.quality },
+            { "Parametric Bypass", 0.f },
+            { "Parametric Dynamic", 0.f },
+            { "Parametric Sidechain", 0.f },
+            { "HighCut Frequency", frequencies.highCut },
+            { "HighCut Slope", (float)slope },
+            { "HighCut Response", (float)Cut_Butterworth },
+            { "HighCut Bypass", 0.f },
+            { "Processing Mode", (float)Mode_Stereo },
+            { "Filter Engine", (float)Engine_Biquad },
+            { "Auto Gain", 0.f },
+            { "Automation Ramp", 0.f },
+        };
+
+        for (auto& ids : getBandParameterIDs())
+            settings.emplace_back(ids.bypass, 1.f);
+
+        return settings;
+    }
+
+
+    void set(Settings& settings, const juce::String& id, float value)
+    {
+        for (auto& setting : settings)
+        {
+            if (setting.first == id)
+            {
+                setting.second = value;
+                return;
+            }
+        }
+
+        settings.emplace_back(id, value);
+    }
+
+    void setBand(Settings& settings, int band, BandType type, float frequency, float gain, float quality, SlopeValues slope = Slope_12dB,
+                 BandChannel channel = BandChannel_Both)
+    {
+        auto& ids = getBandParameterIDs()[(size_t)band];
+
+        set(settings, ids.type, (float)type);
+        set(settings, ids.frequency, frequency);
+        set(settings, ids.gain, gain);
+        set(settings, ids.quality, quality);
+        set(settings, ids.slope, (float)slope);
+        set(settings, ids.channel, (float)channel);
+        set(settings, ids.bypass, 0.f);
+    }
+
+    std::vector<GoldenCase> getGoldenCases()
+    {
+        std::vector<GoldenCase> cases;
+
+        for (auto& frequencies : frequencySettings)
+            for (int slope = 0; slope < numSlopes; ++slope)
+                cases.push_back({ "slope-" + getSlopeName(slope) + "-" + frequencies.name, getSettings(frequencies, slope) });
+
+        for (int bypassed = 0; bypassed < 8; ++bypassed)
+        {
+            GoldenCase c{ "bypass", getSettings(frequencySettings[1], Slope_24dB) };
+
+            const char* bands[] = { "LowCut", "Parametric", "HighCut" };
+
+            for (int band = 0; band < 3; ++band)
+            {
+                if ((bypassed & (1 << band)) != 0)
+                {
+                    set(c.settings, juce::String(bands[band]) + " Bypass", 1.f);
+                    c.name << "-" << juce::String(bands[band]).toLowerCase();
+                }
+            }
+
+            if (bypassed == 0)
+                c.name << "-none";
+
+            cases.push_back(c);
+        }
+
+        // odd and even numbers of sections
+        auto responseNames = getCutResponseNames();
+
+        for (int response = 0; response < responseNames.size(); ++response)
+        {
+            GoldenCase c{ "response-" + responseNames[response].removeCharacters("-").toLowerCase(), getSettings(frequencySettings[1], Slope_36dB) };
+            set(c.settings, "LowCut Response", (float)response);
+            set(c.settings, "HighCut Response", (float)response);
+            set(c.settings, "HighCut Slope", (float)Slope_72dB);
+            cases.push_back(c);
+        }
+
+        // one band of each type in a slot in the middle, then all of them at once in the first and last slots
+        auto typeNames = getBandTypeNames();
+
+        for (int type = 0; type < typeNames.size(); ++type)
+        {
+            GoldenCase c{ "band-" + typeNames[type].removeCharacters(" ").toLowerCase(), getSettings(frequencySettings[1], Slope_24dB) };
+            setBand(c.settings, MaxBands / 2, (BandType)type, 2000.f, 6.f, 1.5f);
+            cases.push_back(c);
+        }
+
+        GoldenCase allBands{ "band-all", getSettings(frequencySettings[1], Slope_24dB) };
+        setBand(allBands.settings, 0, Band_Peak, 250.f, -4.f, 0.8f);
+        setBand(allBands.settings, 1, Band_Notch, 3000.f, 0.f, 4.f);
+        setBand(allBands.settings, MaxBands - 2, Band_Tilt, 1200.f, 3.f, 0.7f);
+        setBand(allBands.settings, MaxBands - 1, Band_BandPass, 900.f, 0.f, 0.3f);
+        cases.push_back(allBands);
+
+        GoldenCase shelves{ "band-shelves", getSettings(frequencySettings[1], Slope_24dB) };
+        setBand(shelves.settings, 2, Band_LowShelf, 150.f, 4.f, 0.7f, Slope_36dB);
+        setBand(shelves.settings, 3, Band_HighShelf, 6000.f, -5.f, 0.7f, Slope_24dB);
+        cases.push_back(shelves);
+
+        // a band on each channel, which stereo mode runs on both
+        auto modeNames = getProcessingModeNames();
+
+        for (int mode = 0; mode < modeNames.size(); ++mode)
+        {
+            GoldenCase c{ "mode-" + modeNames[mode].removeCharacters(" /").toLowerCase(), getSettings(frequencySettings[1], Slope_24dB) };
+            set(c.settings, "Processing Mode", (float)mode);
+            setBand(c.settings, 4, Band_Peak, 700.f, 8.f, 2.f, Slope_12dB, BandChannel_First);
+            setBand(c.settings, 5, Band_HighShelf, 4000.f, -6.f, 0.7f, Slope_24dB, BandChannel_Second);
+            cases.push_back(c);
+        }
+
+        // a boost the output gain takes back, then a cut it makes up for
+        GoldenCase autoGain{ "autogain", getSettings(frequencySettings[2], Slope_24dB) };
+        set(autoGain.settings, "Auto Gain", 1.f);
+        set(autoGain.settings, "LowCut Bypass", 1.f);
+        setBand(autoGain.settings, 3, Band_LowShelf, 300.f, 6.f, 0.7f);
+        cases.push_back(autoGain);
+
+        GoldenCase autoGainAutomation{ "autogain-automation", autoGain.settings };
+        autoGainAutomation.automation[1] = { { "Parametric Gain", -12.f } };
+        cases.push_back(autoGainAutomation);
+
+        // changes closer together than the estimate interval, the later ones are caught up once it has passed
+        GoldenCase autoGainBurst{ "autogain-burst", autoGain.settings };
+        autoGainBurst.automation[1] = { { "Parametric Gain", -12.f } };
+        autoGainBurst.automation[2] = { { "Parametric Gain", -6.f } };
+        autoGainBurst.automation[3] = { { "Band 4 Gain", 12.f } };
+        autoGainBurst.automation[4] = { { "Parametric Gain", 3.f } };
+        cases.push_back(autoGainBurst);
+
+        // a boost that backs off once the signal is over the threshold
+        Settings dynamic{ getSettings(frequencySettings[1], Slope_24dB) };
+        set(dynamic, "Parametric Dynamic", 1.f);
+        set(dynamic, "Parametric Threshold", -30.f);
+        set(dynamic, "Parametric Ratio", 4.f);
+        set(dynamic, "Parametric Attack", 1.f);
+        set(dynamic, "Parametric Release", 50.f);
+        cases.push_back({ "dynamic-input", dynamic });
+
+        GoldenCase sidechain{ "dynamic-sidechain", dynamic };
+        set(sidechain.settings, "Parametric Sidechain", 1.f);
+        sidechain.sidechain = true;
+        cases.push_back(sidechain);
+
+        GoldenCase automation{ "automation", getSettings(frequencySettings[1], Slope_24dB) };
+        automation.automation[1] = { { "LowCut Frequency", 200.f }, { "Parametric Frequency", 2500.f }, { "Parametric Gain", 3.f } };
+        automation.automation[3] = { { "HighCut Frequency", 4000.f }, { "HighCut Slope", (float)Slope_48dB }, { "Parametric Bypass", 1.f } };
+        cases.push_back(automation);
+
+        GoldenCase ramp{ "automation-ramp", automation.settings, automation.automation };
+        set(ramp.settings, "Automation Ramp", 1.f);
+        cases.push_back(ramp);
+
+        // the state variable filters on a bit of everything, then ramping into new settings
+        GoldenCase svf{ "engine-svf", allBands.settings };
+        set(svf.settings, "Filter Engine", (float)Engine_StateVariable);
+        setBand(svf.settings, 2, Band_LowShelf, 150.f, 4.f, 0.7f, Slope_36dB);
+        set(svf.settings, "LowCut Response", (float)Cut_Elliptic);
+        cases.push_back(svf);
+
+        GoldenCase svfMidSide{ "engine-svf-midside", svf.settings };
+        set(svfMidSide.settings, "Processing Mode", (float)Mode_MidSide);
+        setBand(svfMidSide.settings, 1, Band_Notch, 3000.f, 0.f, 4.f, Slope_12dB, BandChannel_Second);
+        cases.push_back(svfMidSide);
+
+        GoldenCase svfAutomation{ "engine-svf-automation", automation.settings, automation.automation };
+        set(svfAutomation.settings, "Filter Engine", (float)Engine_StateVariable);
+        cases.push_back(svfAutomation);
+
+        return cases;
+    }
+
+    juce::AudioBuffer<float> makeSignal(Signal signal, int length)
+    {
+        juce::AudioBuffer<float> buffer(2, length);
+        buffer.clear();
+
+        switch (signal)
+        {
+        case Signal_Impulse:
+            // later and quieter on the right, so crossed channels show
+            buffer.setSample(0, 0, 1.f);
+            buffer.setSample(1, 5, 0.5f);
+            break;
+
+        case Signal_Sweep:
+        {
+            // 20 Hz to 20 kHz, sine on the left and cosine on the right
+            auto rate = std::log(1000.0) / length;
+
+            for (int i = 0; i < length; ++i)
+            {
+                auto phase = juce::MathConstants<double>::twoPi * 20.0 / testSampleRate * (std::exp(rate * i) - 1.0) / rate;
+                buffer.setSample(0, i, 0.5f * (float)std::sin(phase));
+                buffer.setSample(1, i, 0.5f * (float)std::cos(phase));
+            }
+
+            break;
+        }
+
+        case Signal_Noise:
+        {
+            // a generator of its own rather than juce::Random, which the goldens shouldn't depend on
+            juce::uint32 seed = 1;
+
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                for (int i = 0; i < length; ++i)
+                {
+                    seed = seed * 1664525u + 1013904223u;
+                    buffer.setSample(ch, i, 0.5f * (float)(juce::int32)seed / 2147483648.f);
+                }
+            }
+
+            break;
+        }
+
+        default:
+            break;
+        }
+
+        return buffer;
+    }
+
+    // the signal on the main bus and a key on the sidechain bus that is silent at first, then loud
+    juce::AudioBuffer<float> withSidechainKey(const juce::AudioBuffer<float>& signal)
+    {
+        constexpr int keyStart = 64;
+
+        auto key = makeSignal(Signal_Noise, signal.getNumSamples());
+        key.applyGain(0, keyStart, 0.f);
+        key.applyGain(keyStart, signal.getNumSamples() - keyStart, 1.8f);
+
+        juce::AudioBuffer<float> buffer(4, signal.getNumSamples());
+
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            buffer.copyFrom(ch, 0, signal, ch, 0, signal.getNumSamples());
+            buffer.copyFrom(ch + 2, 0, key, ch, 0, signal.getNumSamples());
+        }
+
+        return buffer;
+    }
+
+    bool applySettings(ZXOEQAudioProcessor& processor, const Settings& settings)
+    {
+        for (auto& [id, value] : settings)
+        {
+            auto* parameter = processor.state.getParameter(id);
+
+            if (parameter == nullptr)
+                return false;
+
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+        }
+
+        return true;
+    }
+
+    void prepare(ZXOEQAudioProcessor& processor, int blockSize = maximumBlockSize)
+    {
+        processor.setRateAndBufferSizeDetails(testSampleRate, blockSize);
+        processor.prepareToPlay(testSampleRate, blockSize);
+    }
+
+    // renders in place, cycling through blockSizes unless given a fixed one
+    void render(ZXOEQAudioProcessor& processor, juce::AudioBuffer<float>& buffer, const std::map<int, Settings>& automation = {},
+                int fixedBlockSize = 0)
+    {
+        juce::MidiBuffer midi;
+
+        for (int start = 0, index = 0; start < buffer.getNumSamples(); ++index)
+        {
+            auto it = automation.find(index);
+
+            if (it != automation.end())
+                applySettings(processor, it->second);
+
+            auto blockSize = fixedBlockSize > 0 ? fixedBlockSize : blockSizes[index % juce::numElementsInArray(blockSizes)];
+            blockSize = juce::jmin(blockSize, buffer.getNumSamples() - start);
+            juce::AudioBuffer<float> block(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), start, blockSize);
+
+            processor.processBlock(block, midi);
+            start += blockSize;
+        }
+    }
+
+    bool readGolden(const juce::File& file, juce::AudioBuffer<float>& buffer)
+    {
+        juce::MemoryBlock data;
+
+        if (!file.loadFileAsData(data) || data.getSize() != sizeof(float) * 2 * numSamples)
+            return false;
+
+        buffer.setSize(2, numSamples);
+
+        for (int ch = 0; ch < 2; ++ch)
+            std::memcpy(buffer.getWritePointer(ch), static_cast<const float*>(data.getData()) + ch * numSamples, sizeof(float) * numSamples);
+
+        return true;
+    }
+
+    bool writeGolden(const juce::File& file, const juce::AudioBuffer<float>& buffer)
+    {
+        juce::MemoryBlock data;
+
+        for (int ch = 0; ch < 2; ++ch)
+            data.append(buffer.getReadPointer(ch), sizeof(float) * numSamples);
+
+        return file.replaceWithData(data.getData(), data.getSize());
+    }
+
+    // the magnitudes the editor draws for one channel, from the sections ResponseCurveComponent::updateChain() makes
+    std::vector<double> getCurveDecibels(ZXOEQAudioProcessor& processor, const std::vector<double>& frequencies, int channel)
+    {
+        auto sampleRate = processor.getSampleRate();
+
+        SectionList sections;
+        makeChainSections(getChainParameters(processor.state), sections);
+
+        std::vector<double> decibels;
+
+        for (auto frequency : frequencies)
+        {
+            double magnitude = 1.0;
+
+            for (int i = 0; i < sections.size; ++i)
+                if (sections.appliesToChannel(i, channel))
+                    magnitude *= getMagnitudeForFrequency(makeDigitalSection(sections.sections[i], sampleRate), frequency, sampleRate);
+
+            decibels.push_back(juce::Decibels::gainToDecibels(magnitude, -400.0));
+        }
+
+        return decibels;
+    }
+
+    // the transform of an impulse response at each frequency
+    std::vector<double> getMeasuredDecibels(const float* impulseResponse, int length, const std::vector<double>& frequencies)
+    {
+        std::vector<double> decibels;
+
+        for (auto frequency : frequencies)
+        {
+            std::complex<double> sum;
+            auto step = std::polar(1.0, -juce::MathConstants<double>::twoPi * frequency / testSampleRate);
+            std::complex<double> rotation{ 1.0, 0.0 };
+
+            for (int i = 0; i < length; ++i)
+            {
+                sum += (double)impulseResponse[i] * rotation;
+                rotation *= step;
+            }
+
+            decibels.push_back(juce::Decibels::gainToDecibels(std::abs(sum), -400.0));
+        }
+
+        return decibels;
+    }
+}
+
+//==============================================================================
+struct ProcessorGoldenTests : juce::UnitTest
+{
+    ProcessorGoldenTests() : juce::UnitTest("Processor golden output", "Z-XO-EQ") {}
+
+    void runTest() override
+    {
+        auto& options = getTestOptions();
+
+        if (options.updateGolden)
+            options.goldenDirectory.createDirectory();
+
+        juce::AudioBuffer<float> signals[NumSignals];
+
+        for (int signal = 0; signal < NumSignals; ++signal)
+            signals[signal] = makeSignal((Signal)signal, numSamples);
+
+        juce::String group;
+
+        for (auto& c : getGoldenCases())
+        {
+            auto caseGroup = c.name.upToFirstOccurrenceOf("-", false, false);
+
+            if (caseGroup != group)
+            {
+                beginTest(caseGroup);
+                group = caseGroup;
+            }
+
+            for (int signal = 0; signal < NumSignals; ++signal)
+            {
+                auto name = c.name + "-" + signalNames[signal];
+                auto file = options.goldenDirectory.getChildFile(name + ".bin");
+
+                ZXOEQAudioProcessor processor;
+
+                if (!applySettings(processor, c.settings))
+                {
+                    expect(false, name + ": a parameter of the case doesn't exist");
+                    continue;
+                }
+
+                if (c.sidechain)
+                    processor.getBus(true, 1)->enable();
+
+                prepare(processor);
+
+                auto output = c.sidechain ? withSidechainKey(signals[signal]) : signals[signal];
+                render(processor, output, c.automation);
+                processor.releaseResources();
+
+                juce::AudioBuffer<float> golden;
+                auto hasGolden = readGolden(file, golden);
+
+                double maxError = hasGolden ? 0.0 : std::numeric_limits<double>::infinity();
+                int worstChannel = 0, worstSample = 0;
+
+                for (int ch = 0; hasGolden && ch < 2; ++ch)
+                {
+                    for (int i = 0; i < numSamples; ++i)
+                    {
+                        auto error = std::abs((double)output.getSample(ch, i) - (double)golden.getSample(ch, i));
+
+                        // a NaN fails too
+                        if (!(error <= maxError))
+                        {
+                            maxError = std::isnan(error) ? std::numeric_limits<double>::infinity() : error;
+                            worstChannel = ch;
+                            worstSample = i;
+                        }
+                    }
+                }
+
+                // files that still match are left alone, so an update only touches what really changed
+                if (options.updateGolden)
+                {
+                    if (maxError > options.tolerance)
+                        expect(writeGolden(file, output), "couldn't write " + file.getFullPathName());
+
+                    continue;
+                }
+
+                if (!hasGolden)
+                {
+                    expect(false, file.getFullPathName() + " is missing or has the wrong size, --update-golden writes it");
+                    continue;
+                }
+
+                expect(maxError <= options.tolerance, name + ": channel " + juce::String(worstChannel) + " sample " + juce::String(worstSample)
+                    + " is off by " + juce::String(maxError) + ", more than " + juce::String(options.tolerance));
+            }
+        }
+    }
+};
+
+//==============================================================================
+struct ResponseCurveTests : juce::UnitTest
+{
+    ResponseCurveTests() : juce::UnitTest("Response curve", "Z-XO-EQ") {}
+
+    void runTest() override
+    {
+        // long enough for the lowest, steepest cut to ring out
+        constexpr int impulseLength = 32768;
+
+        std::vector<double> frequencies;
+
+        for (double frequency = 20.0; frequency < 20000.0; frequency *= 1.12)
+            frequencies.push_back(frequency);
+
+        for (auto& c : getGoldenCases())
+        {
+            // the curve shows the dynamic band at rest, which the audio isn't
+            if (!c.automation.empty() || c.name.startsWith("dynamic"))
+                continue;
+
+            beginTest(c.name);
+
+            ZXOEQAudioProcessor processor;
+            expect(applySettings(processor, c.settings));
+            prepare(processor);
+
+            juce::AudioBuffer<float> impulse(2, impulseLength);
+            impulse.clear();
+            impulse.setSample(0, 0, 1.f);
+            impulse.setSample(1, 0, 1.f);
+
+            render(processor, impulse);
+
+            // single precision filtering moves the low cut's poles, so its first octave and the deep stopband
+            // sound a little different from the curve
+            auto chainParameters = getChainParameters(processor.state);
+            auto lowestFrequency = chainParameters.lowCutBypass ? 0.0 : 2.0 * chainParameters.lowCutFrequency;
+
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                // the same impulse on both sides is all mid, so mid/side comes out with the mid curve on both
+                auto curve = getCurveDecibels(processor, frequencies, chainParameters.processingMode == Mode_MidSide ? 0 : ch);
+                auto measured = getMeasuredDecibels(impulse.getReadPointer(ch), impulseLength, frequencies);
+
+                std::vector<size_t> compared;
+
+                for (size_t i = 0; i < frequencies.size(); ++i)
+                    if (frequencies[i] >= lowestFrequency && curve[i] > -60.0)
+                        compared.push_back(i);
+
+                // auto gain moves the whole response by a gain the curve leaves out, a boost comes out quieter
+                double offset = 0.0;
+
+                if (chainParameters.autoGain)
+                {
+                    for (auto i : compared)
+                        offset += (measured[i] - curve[i]) / (double)compared.size();
+
+                    expect(offset < -0.1 && offset >= -24.0, "auto gain of " + juce::String(offset) + " dB");
+                }
+
+                for (auto i : compared)
+                    expectWithinAbsoluteError(measured[i], curve[i] + offset, 0.05,
+                        "channel " + juce::String(ch) + " at " + juce::String(frequencies[i], 1) + " Hz");
+            }
+
+            processor.releaseResources();
+        }
+    }
+};
+
+//==============================================================================
+struct SilenceSkipTests : juce::UnitTest
+{
+    SilenceSkipTests() : juce::UnitTest("Silence skip", "Z-XO-EQ") {}
+
+    void runTest() override
+    {
+        beginTest("Sound after a skipped silence");
+
+        auto settings = getSettings(frequencySettings[1], Slope_48dB);
+
+        ZXOEQAudioProcessor processor;
+        expect(applySettings(processor, settings));
+        prepare(processor);
+
+        auto tail = (int)std::ceil(processor.getTailLengthSeconds() * testSampleRate);
+        expect(tail > 0, "the filters ring, so the tail can't be empty");
+
+        // an impulse, silence long enough to skip a few blocks, then the same impulse again
+        auto secondImpulse = tail + 4 * maximumBlockSize;
+        auto length = secondImpulse + numSamples;
+
+        juce::AudioBuffer<float> output(2, length);
+        output.clear();
+
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            output.setSample(ch, 0, 1.f);
+            output.setSample(ch, secondImpulse, 1.f);
+        }
+
+        render(processor, output);
+
+        // the second impulse has to sound like one into filters that never heard anything
+        ZXOEQAudioProcessor fresh;
+        expect(applySettings(fresh, settings));
+        prepare(fresh);
+
+        juce::AudioBuffer<float> expected(2, length);
+        expected.clear();
+
+        for (int ch = 0; ch < 2; ++ch)
+            expected.setSample(ch, secondImpulse, 1.f);
+
+        render(fresh, expected);
+
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            for (int i = tail + 2 * maximumBlockSize; i < secondImpulse - maximumBlockSize; ++i)
+                expectEquals(output.getSample(ch, i), 0.f, "skipped samples are silent");
+
+            for (int i = secondImpulse; i < length; ++i)
+                expectWithinAbsoluteError(output.getSample(ch, i), expected.getSample(ch, i), 1.0e-6f,
+                    "channel " + juce::String(ch) + " sample " + juce::String(i - secondImpulse) + " after the second impulse");
+        }
+
+        processor.releaseResources();
+        fresh.releaseResources();
+    }
+};
+
+//==============================================================================
+struct OfflineRenderTests : juce::UnitTest
+{
+    OfflineRenderTests() : juce::UnitTest("Offline render", "Z-XO-EQ") {}
+
+    void runTest() override
+    {
+        // the pool is only there with the variable set when the first processor makes it
+       #if JUCE_WINDOWS
+        _putenv_s("ZXOEQ_OFFLINE_THREADS", "2");
+       #else
+        setenv("ZXOEQ_OFFLINE_THREADS", "2", 1);
+       #endif
+
+        // large enough for the channels to go to the pool
+        constexpr int offlineBlockSize = 1024;
+
+        const juce::StringArray caseNames{ "bypass-none", "band-all", "mode-leftright", "mode-midside", "dynamic-input", "automation-ramp",
+                                           "engine-svf" };
+        auto noise = makeSignal(Signal_Noise, 4 * offlineBlockSize);
+
+        for (auto& c : getGoldenCases())
+        {
+            if (!caseNames.contains(c.name))
+                continue;
+
+            beginTest(c.name);
+
+            juce::AudioBuffer<float> outputs[2];
+
+            for (auto nonRealtime : { false, true })
+            {
+                ZXOEQAudioProcessor processor;
+                expect(applySettings(processor, c.settings));
+                processor.setNonRealtime(nonRealtime);
+                prepare(processor, offlineBlockSize);
+
+                auto& output = outputs[nonRealtime ? 1 : 0];
+                output = noise;
+                render(processor, output, c.automation, offlineBlockSize);
+                processor.releaseResources();
+            }
+
+            for (int ch = 0; ch < 2; ++ch)
+                for (int i = 0; i < noise.getNumSamples(); ++i)
+                    expectWithinAbsoluteError(outputs[1].getSample(ch, i), outputs[0].getSample(ch, i), 1.0e-6f,
+                        "channel " + juce::String(ch) + " sample " + juce::String(i));
+        }
+
+        beginTest("More jobs than helpers");
+
+        {
+            juce::SharedResourcePointer<OfflineRenderPool> pool;
+            expect(pool->isEnabled());
+
+            std::array<std::atomic<int>, 3 * OfflineRenderPool::MaxHelpers> calls{};
+            pool->run((int)calls.size(), [&calls](int job) { ++calls[(size_t)job]; });
+
+            for (size_t i = 0; i < calls.size(); ++i)
+                expectEquals(calls[i].load(), 1, "job " + juce::String((int)i));
+        }
+    }
+};
+
+static ProcessorGoldenTests processorGoldenTests;
+static ResponseCurveTests responseCurveTests;
+static SilenceSkipTests silenceSkipTests;
+static OfflineRenderTests offlineRenderTests;
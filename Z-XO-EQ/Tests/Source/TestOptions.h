@@ -0,0 +1,30 @@
+/*
+  ==============================================================================
+
+    What the command line sets for the tests that compare against data
+    checked in next to them.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct TestOptions
+{
+    // Tests/Golden, found from where this file was compiled unless --golden names another directory
+    juce::File goldenDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(__FILE__).getParentDirectory().getSiblingFile("Golden");
+
+    // the largest difference a sample may have from its golden value
+    double tolerance = 1.0e-4;
+
+    // rewrite the golden files this build no longer matches instead of failing
+    bool updateGolden = false;
+};
+
+inline TestOptions& getTestOptions()
+{
+    static TestOptions options;
+    return options;
+}